@@ -0,0 +1,81 @@
+// Benchmark driver: runs the robdd pipeline on one PLA, times each phase and
+// appends one CSV row to standard output (see "make bench").
+//
+//   robdd_bench <case> <input.pla> <obdd|apply> <output.dot>
+//   robdd_bench --header-only
+//
+// In obdd mode, build is the full OBDD tree and reduce is reduceToRobdd. In
+// apply mode, build is buildRobddFromPla, which includes its final compaction,
+// so reduce is 0. dot is the time to write every DOT file of the mode. Peak RSS
+// is for the whole process, so run each case in its own process.
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include "../src/PlaParser.h"
+#include "../src/RobddManager.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static long peakRssKb() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss; // kilobytes on Linux
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 2 && std::string(argv[1]) == "--header-only") {
+        std::cout << "case,mode,inputs,outputs,cubes,parse_ms,build_ms,reduce_ms,dot_ms,total_ms,"
+                     "obdd_nodes,robdd_nodes,peak_rss_kb" << std::endl;
+        return 0;
+    }
+    if (argc != 5) {
+        std::cerr << "Usage: " << argv[0] << " <case> <input.pla> <obdd|apply> <output.dot>" << std::endl;
+        std::cerr << "       " << argv[0] << " --header-only" << std::endl;
+        return 1;
+    }
+    std::string name = argv[1], pla = argv[2], mode = argv[3], dot = argv[4];
+    if (mode != "obdd" && mode != "apply") {
+        std::cerr << "[Error] Unknown mode: " << mode << std::endl;
+        return 1;
+    }
+
+    Clock::time_point start = Clock::now();
+    PlaParser parser;
+    if (!parser.parse(pla)) return 1;
+    double parse_ms = msSince(start);
+
+    RobddManager mgr;
+    double build_ms = 0, reduce_ms = 0, dot_ms = 0;
+    size_t obdd_nodes = 0;
+    Clock::time_point t = Clock::now();
+    if (mode == "obdd") {
+        if (!mgr.buildObddFromPla(parser)) return 1;
+        build_ms = msSince(t);
+        obdd_nodes = mgr.getNodeCount();
+        t = Clock::now();
+        std::string obdd_dot = dot.substr(0, dot.size() - (dot.size() >= 4 ? 4 : 0)) + "_obdd.dot";
+        mgr.writeObddDot(obdd_dot);
+        dot_ms += msSince(t);
+        t = Clock::now();
+        if (!mgr.reduceToRobdd()) return 1;
+        reduce_ms = msSince(t);
+    } else {
+        if (!mgr.buildRobddFromPla(parser)) return 1;
+        build_ms = msSince(t);
+    }
+    t = Clock::now();
+    mgr.writeRobddDot(dot);
+    dot_ms += msSince(t);
+    double total_ms = msSince(start);
+
+    std::cout << name << ',' << mode << ',' << parser.getNumInputs() << ',' << parser.getNumOutputs() << ','
+              << parser.getNumTerms() << ',' << parse_ms << ',' << build_ms << ',' << reduce_ms << ','
+              << dot_ms << ',' << total_ms << ',' << obdd_nodes << ',' << mgr.getNodeCount() << ','
+              << peakRssKb() << std::endl;
+    return 0;
+}
@@ -0,0 +1,134 @@
+// Synthetic PLA generator for the benchmark suite (see "make bench").
+//
+//   plagen random <inputs> <cubes> <dc> [seed]   random cubes, dc = don't-care probability
+//   plagen adder <bits>                          a + b, bits + 1 outputs (minterms)
+//   plagen comparator <bits>                     a > b, a == b, a < b
+//   plagen mux <select bits>                     2^s data inputs selected by s lines
+//
+// The PLA is written to standard output.
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static void printHeader(const std::vector<std::string>& inputs, const std::vector<std::string>& outputs, size_t terms) {
+    std::cout << ".i " << inputs.size() << "\n.o " << outputs.size() << "\n.ilb";
+    for (const auto& n : inputs) std::cout << ' ' << n;
+    std::cout << "\n.ob";
+    for (const auto& n : outputs) std::cout << ' ' << n;
+    std::cout << "\n.p " << terms << "\n";
+}
+
+// Names a[bits-1] ... a[0] then b[bits-1] ... b[0], most significant bit first.
+static std::vector<std::string> operandNames(int bits) {
+    std::vector<std::string> names;
+    for (char op : {'a', 'b'}) {
+        for (int i = bits - 1; i >= 0; --i) names.push_back(std::string(1, op) + std::to_string(i));
+    }
+    return names;
+}
+
+static void randomPla(int n, int cubes, double dc, unsigned seed) {
+    std::vector<std::string> inputs;
+    for (int i = 0; i < n; ++i) inputs.push_back("x" + std::to_string(i));
+    printHeader(inputs, {"f"}, cubes);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uni(0.0, 1.0);
+    std::string cube(n, '-');
+    for (int c = 0; c < cubes; ++c) {
+        for (int i = 0; i < n; ++i) cube[i] = uni(rng) < dc ? '-' : (rng() & 1 ? '1' : '0');
+        std::cout << cube << " 1\n";
+    }
+}
+
+// One minterm per (a, b) with a non-zero sum.
+static void adderPla(int bits) {
+    std::vector<std::string> outputs;
+    for (int i = bits; i >= 0; --i) outputs.push_back("s" + std::to_string(i));
+    uint64_t half = 1ULL << bits;
+    printHeader(operandNames(bits), outputs, half * half - 1);
+    std::string cube(2 * bits, '0'), out(bits + 1, '0');
+    for (uint64_t a = 0; a < half; ++a) {
+        for (uint64_t b = 0; b < half; ++b) {
+            uint64_t s = a + b;
+            if (s == 0) continue;
+            for (int i = 0; i < bits; ++i) {
+                cube[bits - 1 - i] = (a >> i) & 1 ? '1' : '0';
+                cube[2 * bits - 1 - i] = (b >> i) & 1 ? '1' : '0';
+            }
+            for (int i = 0; i <= bits; ++i) out[bits - i] = (s >> i) & 1 ? '1' : '0';
+            std::cout << cube << ' ' << out << "\n";
+        }
+    }
+}
+
+// gt/lt: one cube per deciding bit i and per assignment of the equal higher
+// bits; eq: one cube per assignment of all bits.
+static void comparatorPla(int bits) {
+    std::vector<std::string> cubes, outs;
+    std::string cube(2 * bits, '-');
+    for (int i = 0; i < bits; ++i) {          // i = position from the top
+        int higher = i;
+        for (uint64_t m = 0; m < (1ULL << higher); ++m) {
+            std::fill(cube.begin(), cube.end(), '-');
+            for (int j = 0; j < higher; ++j) {
+                char v = (m >> j) & 1 ? '1' : '0';
+                cube[j] = v;
+                cube[bits + j] = v;
+            }
+            cube[i] = '1'; cube[bits + i] = '0';
+            cubes.push_back(cube); outs.push_back("100");
+            cube[i] = '0'; cube[bits + i] = '1';
+            cubes.push_back(cube); outs.push_back("001");
+        }
+    }
+    for (uint64_t m = 0; m < (1ULL << bits); ++m) {
+        for (int j = 0; j < bits; ++j) {
+            char v = (m >> j) & 1 ? '1' : '0';
+            cube[j] = v;
+            cube[bits + j] = v;
+        }
+        cubes.push_back(cube); outs.push_back("010");
+    }
+    printHeader(operandNames(bits), {"gt", "eq", "lt"}, cubes.size());
+    for (size_t k = 0; k < cubes.size(); ++k) std::cout << cubes[k] << ' ' << outs[k] << "\n";
+}
+
+// Select lines first, then the data inputs; a known order-sensitive function.
+static void muxPla(int sel) {
+    int data = 1 << sel;
+    std::vector<std::string> inputs;
+    for (int i = sel - 1; i >= 0; --i) inputs.push_back("s" + std::to_string(i));
+    for (int d = 0; d < data; ++d) inputs.push_back("d" + std::to_string(d));
+    printHeader(inputs, {"y"}, data);
+    std::string cube(sel + data, '-');
+    for (int d = 0; d < data; ++d) {
+        std::fill(cube.begin(), cube.end(), '-');
+        for (int i = 0; i < sel; ++i) cube[sel - 1 - i] = (d >> i) & 1 ? '1' : '0';
+        cube[sel + d] = '1';
+        std::cout << cube << " 1\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string kind = argc > 1 ? argv[1] : "";
+    if (kind == "random" && argc >= 5) {
+        randomPla(std::atoi(argv[2]), std::atoi(argv[3]), std::atof(argv[4]), argc > 5 ? std::atoi(argv[5]) : 1);
+    } else if (kind == "adder" && argc == 3) {
+        adderPla(std::atoi(argv[2]));
+    } else if (kind == "comparator" && argc == 3) {
+        comparatorPla(std::atoi(argv[2]));
+    } else if (kind == "mux" && argc == 3) {
+        muxPla(std::atoi(argv[2]));
+    } else {
+        std::cerr << "Usage: " << argv[0] << " random <inputs> <cubes> <dc> [seed]" << std::endl;
+        std::cerr << "       " << argv[0] << " adder|comparator <bits>" << std::endl;
+        std::cerr << "       " << argv[0] << " mux <select bits>" << std::endl;
+        return 1;
+    }
+    std::cout << ".e\n";
+    return 0;
+}
@@ -0,0 +1,34 @@
+#!/bin/sh
+# Generates the benchmark PLAs and appends one CSV row per (case, mode).
+# Usage: bench/run_bench.sh <bench dir> <results.csv>
+set -e
+DIR=$1
+CSV=$2
+GEN=$DIR/plagen
+RUN=$DIR/robdd_bench
+WORK=$DIR/work
+mkdir -p "$WORK"
+
+# name | generator arguments | modes (the OBDD tree is 2^n, keep it to small n)
+CASES="
+rand12|random 12 200 0.5 1|obdd apply
+rand16|random 16 300 0.4 2|obdd apply
+rand24|random 24 3000 0.35 3|apply
+rand32|random 32 2000 0.4 4|apply
+adder4|adder 4|obdd apply
+adder8|adder 8|apply
+cmp6|comparator 6|obdd apply
+cmp12|comparator 12|apply
+mux3|mux 3|obdd apply
+mux5|mux 5|apply
+"
+
+"$RUN" --header-only > "$CSV"
+echo "$CASES" | while IFS='|' read -r name args modes; do
+    [ -n "$name" ] || continue
+    "$GEN" $args > "$WORK/$name.pla"
+    for mode in $modes; do
+        echo "  -> $name ($mode)"
+        "$RUN" "$name" "$WORK/$name.pla" "$mode" "$WORK/$name.dot" >> "$CSV"
+    done
+done
@@ -0,0 +1,311 @@
+#include "BddImage.h"
+#include "RobddManager.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char kMagic[8] = {'R', 'O', 'B', 'D', 'D', 'I', 'M', 'G'};
+static const uint32_t kByteOrder = 0x01020304;
+
+static uint64_t alignUp(uint64_t n) {
+    return (n + 7) & ~(uint64_t)7;
+}
+
+// ---------------- Writing ----------------
+
+bool BddImage::write(const RobddManager& mgr, const std::string& path, uint64_t key) {
+    const std::vector<RobddManager::Node>& mnodes = mgr.nodes;
+    uint32_t n = (uint32_t)mgr.var_names.size();
+
+    // Record order: internal nodes by level, deepest first; stable, so a graph
+    // fresh from reduceToRobdd keeps its id order.
+    std::vector<int> ids;
+    for (size_t id = 2; id < mnodes.size(); ++id) ids.push_back((int)id);
+    std::stable_sort(ids.begin(), ids.end(), [&](int a, int b) {
+        return mgr.var_level[mnodes[a].var_index] > mgr.var_level[mnodes[b].var_index];
+    });
+    if (ids.size() >= (1u << 31)) {
+        std::cerr << "[Error] Graph too large for the image format: " << ids.size() << " nodes" << std::endl;
+        return false;
+    }
+    std::vector<uint32_t> pos(mnodes.size(), 0); // node id -> record index; the terminal is record 0
+    for (size_t i = 0; i < ids.size(); ++i) pos[ids[i]] = (uint32_t)(i + 1);
+
+    std::string names;
+    for (const auto& s : mgr.var_names) names.append(s).push_back('\0');
+    for (const auto& s : mgr.output_names) names.append(s).push_back('\0');
+
+    Header h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion;
+    h.byte_order = kByteOrder;
+    h.num_inputs = n;
+    h.num_outputs = (uint32_t)mgr.roots.size();
+    h.num_nodes = ids.size() + 1;
+    h.key = key;
+    h.order_offset = alignUp(sizeof(Header));
+    h.roots_offset = alignUp(h.order_offset + (uint64_t)n * sizeof(uint32_t));
+    h.nodes_offset = alignUp(h.roots_offset + (uint64_t)h.num_outputs * sizeof(uint64_t));
+    h.names_offset = alignUp(h.nodes_offset + h.num_nodes * sizeof(Record));
+    h.names_size = names.size();
+    h.file_size = h.names_offset + h.names_size;
+
+    std::vector<char> buf(h.file_size, 0);
+    std::memcpy(buf.data(), &h, sizeof(h));
+    uint32_t* out_order = reinterpret_cast<uint32_t*>(buf.data() + h.order_offset);
+    for (uint32_t l = 0; l < n; ++l) out_order[l] = (uint32_t)mgr.var_order[l];
+    uint64_t* out_roots = reinterpret_cast<uint64_t*>(buf.data() + h.roots_offset);
+    for (size_t k = 0; k < mgr.roots.size(); ++k) {
+        int r = mgr.roots[k];
+        out_roots[k] = ((uint64_t)pos[r >> 1] << 1) | (r & 1);
+    }
+    Record* out_nodes = reinterpret_cast<Record*>(buf.data() + h.nodes_offset);
+    out_nodes[0] = {n, 0, 0};
+    for (size_t i = 0; i < ids.size(); ++i) {
+        const RobddManager::Node& nd = mnodes[ids[i]];
+        uint32_t self = (uint32_t)(i + 1);
+        auto rel = [&](int e) { return ((self - pos[e >> 1]) << 1) | (uint32_t)(e & 1); };
+        out_nodes[self] = {(uint32_t)mgr.var_level[nd.var_index], rel(nd.else_id), rel(nd.then_id)};
+    }
+    std::memcpy(buf.data() + h.names_offset, names.data(), names.size());
+
+    std::string tmp = path + ".tmp" + std::to_string(getpid());
+    std::ofstream file(tmp, std::ios::binary);
+    file.write(buf.data(), buf.size());
+    file.close();
+    if (!file) {
+        std::cerr << "[Error] Cannot write " << path << std::endl;
+        std::remove(tmp.c_str());
+        return false;
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::cerr << "[Error] Cannot write " << path << std::endl;
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// ---------------- Reading ----------------
+
+bool BddImage::isImage(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(kMagic)];
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool BddImage::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "[Error] Cannot open " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(Header)) {
+        map = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) map = nullptr;
+        else map_size = (size_t)st.st_size;
+    }
+    ::close(fd);
+
+    const char* base = static_cast<const char*>(map);
+    const Header* h = static_cast<const Header*>(map);
+    const char* problem = nullptr;
+    if (!h || std::memcmp(h->magic, kMagic, sizeof(kMagic)) != 0) problem = "not a ROBDD image";
+    else if (h->byte_order != kByteOrder) problem = "written with another byte order";
+    else if (h->version != kVersion) problem = "unsupported version";
+    else if (h->file_size != map_size || h->num_nodes == 0 ||
+             h->order_offset + (uint64_t)h->num_inputs * sizeof(uint32_t) > map_size ||
+             h->roots_offset + (uint64_t)h->num_outputs * sizeof(uint64_t) > map_size ||
+             h->num_nodes > map_size / sizeof(Record) ||
+             h->nodes_offset + h->num_nodes * sizeof(Record) > map_size ||
+             h->names_offset + h->names_size > map_size ||
+             (h->order_offset | h->roots_offset | h->nodes_offset) % 8 != 0) problem = "truncated or corrupt";
+    if (problem) {
+        std::cerr << "[Error] " << path << ": " << problem << std::endl;
+        close();
+        return false;
+    }
+
+    header = h;
+    order = reinterpret_cast<const uint32_t*>(base + h->order_offset);
+    roots = reinterpret_cast<const uint64_t*>(base + h->roots_offset);
+    nodes = reinterpret_cast<const Record*>(base + h->nodes_offset);
+    const char* p = base + h->names_offset;
+    const char* end = p + h->names_size;
+    for (uint32_t i = 0; i < h->num_inputs + h->num_outputs && p < end; ++i) {
+        const char* nul = static_cast<const char*>(std::memchr(p, '\0', end - p));
+        if (!nul) break;
+        (i < h->num_inputs ? input_names : output_names).push_back(std::string(p, nul));
+        p = nul + 1;
+    }
+    for (uint32_t v = (uint32_t)input_names.size(); v < h->num_inputs; ++v) input_names.push_back("x" + std::to_string(v));
+    for (uint32_t k = (uint32_t)output_names.size(); k < h->num_outputs; ++k) output_names.push_back("out" + std::to_string(k));
+    return true;
+}
+
+void BddImage::close() {
+    if (map) munmap(map, map_size);
+    map = nullptr;
+    map_size = 0;
+    header = nullptr;
+    order = nullptr;
+    roots = nullptr;
+    nodes = nullptr;
+    input_names.clear();
+    output_names.clear();
+}
+
+bool BddImage::evaluate(const std::vector<char>& values, int k, bool& value) const {
+    uint64_t pos = roots[k] >> 1;
+    unsigned neg = roots[k] & 1;
+    if (pos >= header->num_nodes) return false;
+    while (pos != 0) {
+        const Record& r = nodes[pos];
+        if (r.level >= header->num_inputs || order[r.level] >= header->num_inputs) return false;
+        uint32_t e = values[order[r.level]] ? r.then_id : r.else_id;
+        uint32_t dist = e >> 1;
+        if (dist == 0 || dist > pos) return false;
+        neg ^= e & 1;
+        pos -= dist;
+    }
+    value = neg != 0; // the complemented terminal is TRUE
+    return true;
+}
+
+long double BddImage::satCount(int k) const {
+    // Same two-sided pass as RobddManager::probability with every input at 1/2.
+    size_t count = header->num_nodes;
+    std::vector<long double> p0(count), p1(count);
+    p0[0] = 1;
+    p1[0] = 0;
+    auto prob = [&](size_t self, uint32_t e, bool one) {
+        size_t child = (e >> 1) <= self ? self - (e >> 1) : 0;
+        return ((e & 1) != 0) != one ? p1[child] : p0[child];
+    };
+    for (size_t i = 1; i < count; ++i) {
+        const Record& r = nodes[i];
+        p0[i] = (prob(i, r.else_id, false) + prob(i, r.then_id, false)) / 2;
+        p1[i] = (prob(i, r.else_id, true) + prob(i, r.then_id, true)) / 2;
+    }
+    uint64_t root = roots[k];
+    size_t pos = (root >> 1) < count ? root >> 1 : 0;
+    long double p = (root & 1) ? p0[pos] : p1[pos];
+    return std::ldexp(p, (int)header->num_inputs);
+}
+
+bool BddImage::toManager(RobddManager& mgr) const {
+    if (!header) return false;
+    uint32_t n = header->num_inputs;
+    std::vector<int> var_order(order, order + n);
+    std::vector<char> seen(n, 0);
+    for (int v : var_order) {
+        if (v < 0 || (uint32_t)v >= n || seen[v]) {
+            std::cerr << "[Error] Image has an invalid variable order." << std::endl;
+            return false;
+        }
+        seen[v] = 1;
+    }
+
+    // Record i becomes node id i + 1 (id 1 is reserved); the terminal stays 0.
+    auto edge = [](uint64_t record, unsigned neg) { return (int)(((record == 0 ? 0 : record + 1) << 1) | neg); };
+    std::vector<RobddManager::Node> mnodes;
+    mnodes.reserve(header->num_nodes + 1);
+    mnodes.push_back({0, 0, -1});
+    mnodes.push_back({1, 1, -1});
+    for (uint64_t i = 1; i < header->num_nodes; ++i) {
+        const Record& r = nodes[i];
+        uint32_t kids[2] = {r.else_id, r.then_id};
+        bool ok = r.level < n;
+        for (uint32_t e : kids) {
+            uint32_t dist = e >> 1;
+            ok = ok && dist != 0 && dist <= i && nodes[i - dist].level > r.level;
+        }
+        if (!ok) {
+            std::cerr << "[Error] Image node " << i << " is out of range." << std::endl;
+            return false;
+        }
+        mnodes.push_back({edge(i - (r.else_id >> 1), r.else_id & 1), edge(i - (r.then_id >> 1), r.then_id & 1),
+                          var_order[r.level]});
+    }
+    std::vector<int> mroots;
+    for (uint32_t k = 0; k < header->num_outputs; ++k) {
+        if ((roots[k] >> 1) >= header->num_nodes) {
+            std::cerr << "[Error] Image root " << k << " is out of range." << std::endl;
+            return false;
+        }
+        mroots.push_back(edge(roots[k] >> 1, roots[k] & 1));
+    }
+
+    mgr.var_names = input_names;
+    mgr.output_names = output_names;
+    mgr.initial_order = var_order;
+    mgr.resetVarOrder();
+    mgr.resetNodes();
+    mgr.nodes.swap(mnodes);
+    mgr.roots.swap(mroots);
+    return mgr.reduceToRobdd();
+}
+
+// ---------------- Hashing ----------------
+
+// Word-at-a-time multiply-rotate hash with a final avalanche. Not
+// cryptographic; collisions only matter as far as a stale cache hit would.
+uint64_t BddImage::hashBytes(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint64_t h = seed ^ (size * 0x9E3779B97F4A7C15ULL);
+    auto mix = [&h](uint64_t w) {
+        h ^= w * 0xC2B2AE3D27D4EB4FULL;
+        h = (h << 31 | h >> 33) * 0x9E3779B97F4A7C15ULL;
+    };
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, p + i, 8);
+        mix(w);
+    }
+    if (i < size) {
+        uint64_t w = 0;
+        std::memcpy(&w, p + i, size - i);
+        mix(w);
+    }
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    return h;
+}
+
+bool BddImage::hashFile(const std::string& path, uint64_t& hash) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "[Error] Cannot open " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    void* m = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        m = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    if (m != MAP_FAILED) {
+        madvise(m, (size_t)st.st_size, MADV_SEQUENTIAL);
+        hash = hashBytes(m, (size_t)st.st_size, 0);
+        munmap(m, (size_t)st.st_size);
+    } else {
+        std::vector<char> buf;
+        char chunk[1 << 16];
+        ssize_t got;
+        while ((got = read(fd, chunk, sizeof(chunk))) > 0) buf.insert(buf.end(), chunk, chunk + got);
+        hash = hashBytes(buf.data(), buf.size(), 0);
+    }
+    ::close(fd);
+    return true;
+}
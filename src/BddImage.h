@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class RobddManager;
+
+// Versioned binary file of a reduced ROBDD (".robdd"), used by --save, by the
+// --cache result cache, and as an input in place of a PLA.
+//
+// Layout (native byte order, sections 8-byte aligned):
+//   Header   magic "ROBDDIMG", version, sizes, section offsets, cache key
+//   order    num_inputs x uint32: level -> input variable
+//   roots    num_outputs x uint64 edges
+//   nodes    num_nodes x {level, else, then} (uint32 each)
+//   names    input then output names, each NUL-terminated
+//
+// Record 0 is the terminal; the others are sorted by level, deepest first, so
+// every child comes before its parent. Edges are (distance << 1) | complement,
+// where the distance is the parent's record index minus the child's (roots use
+// the absolute index), with the same complement semantics as RobddManager.
+//
+// open() maps the file read-only and checks only the header and section bounds,
+// so loading is O(1) in the graph size; evaluate() and satCount() query the
+// mapping directly. toManager() checks every record and rebuilds a manager.
+class BddImage {
+public:
+    static const uint32_t kVersion = 1;
+
+    BddImage() = default;
+    ~BddImage() { close(); }
+    BddImage(const BddImage&) = delete;
+    BddImage& operator=(const BddImage&) = delete;
+
+    // Writes the reduced graph of mgr to path (through a temporary file and a
+    // rename, so readers never see a partial file). key is stored for --cache.
+    // Returns false if the file cannot be written.
+    static bool write(const RobddManager& mgr, const std::string& path, uint64_t key = 0);
+
+    // True if the file at path starts with the image magic.
+    static bool isImage(const std::string& path);
+
+    // Maps an image. Returns false with a message if the file is missing,
+    // truncated, of another version or byte order.
+    bool open(const std::string& path);
+    void close();
+
+    uint64_t getKey() const { return header ? header->key : 0; }
+    int getNumInputs() const { return header ? (int)header->num_inputs : 0; }
+    int getNumOutputs() const { return header ? (int)header->num_outputs : 0; }
+    size_t getNodeCount() const { return header && header->num_nodes > 0 ? header->num_nodes - 1 : 0; }
+    const std::vector<std::string>& getInputNames() const { return input_names; }
+    const std::vector<std::string>& getOutputNames() const { return output_names; }
+
+    // Sets value to output k for one assignment (values[v] is input v, 0 or 1).
+    // Returns false if the walk leaves the node section of a corrupt file.
+    bool evaluate(const std::vector<char>& values, int k, bool& value) const;
+
+    // Number of assignments for which output k is 1, as RobddManager::satCount.
+    long double satCount(int k = 0) const;
+
+    // Replaces the contents of mgr with this graph, reduced and numbered as by
+    // RobddManager::reduceToRobdd. Returns false if a record is out of range.
+    bool toManager(RobddManager& mgr) const;
+
+    // 64-bit hash of a byte range, and of a whole file (mapped, or read where
+    // mapping fails). Used for --cache keys.
+    static uint64_t hashBytes(const void* data, size_t size, uint64_t seed);
+    static bool hashFile(const std::string& path, uint64_t& hash);
+
+private:
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order; // kByteOrder as written
+        uint32_t num_inputs;
+        uint32_t num_outputs;
+        uint64_t num_nodes;  // records, including the terminal
+        uint64_t key;
+        uint64_t order_offset;
+        uint64_t roots_offset;
+        uint64_t nodes_offset;
+        uint64_t names_offset;
+        uint64_t names_size;
+        uint64_t file_size;
+    };
+    struct Record {
+        uint32_t level;   // num_inputs for the terminal
+        uint32_t else_id;
+        uint32_t then_id;
+    };
+
+    void* map = nullptr;
+    size_t map_size = 0;
+    const Header* header = nullptr;
+    const uint32_t* order = nullptr;
+    const uint64_t* roots = nullptr;
+    const Record* nodes = nullptr;
+    std::vector<std::string> input_names;
+    std::vector<std::string> output_names;
+};
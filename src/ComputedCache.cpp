@@ -0,0 +1,50 @@
+#include "ComputedCache.h"
+
+static size_t roundUpPow2(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+ComputedCache::ComputedCache(size_t min_capacity, size_t max_capacity)
+    : min_capacity(roundUpPow2(min_capacity < 16 ? 16 : min_capacity)),
+      max_capacity(roundUpPow2(max_capacity)) {
+    if (this->max_capacity < this->min_capacity) this->max_capacity = this->min_capacity;
+    clear();
+}
+
+void ComputedCache::clear() {
+    slots.assign(min_capacity, Slot{-1, -1, -1, -1});
+    mask = min_capacity - 1;
+    used = 0;
+    grow_at = min_capacity / 2;
+}
+
+// Doubles the cache and keeps every entry; in the larger table two old entries
+// never compete for one slot, since each maps to a distinct slot pair.
+void ComputedCache::grow() {
+    std::vector<Slot> old;
+    old.swap(slots);
+    slots.assign(old.size() * 2, Slot{-1, -1, -1, -1});
+    mask = slots.size() - 1;
+    grow_at = slots.size() / 2;
+    for (const Slot& s : old) {
+        if (s.f >= 0) slots[hash(s.f, s.g, s.h) & mask] = s;
+    }
+}
+
+void ComputedCache::remap(const std::vector<int>& node_map) {
+    std::vector<Slot> old;
+    old.swap(slots);
+    slots.assign(old.size(), Slot{-1, -1, -1, -1});
+    used = 0;
+    auto mapEdge = [&](int e) { int id = node_map[e >> 1]; return id < 0 ? -1 : (id << 1) | (e & 1); };
+    for (const Slot& s : old) {
+        if (s.f < 0) continue;
+        Slot n = {mapEdge(s.f), mapEdge(s.g), mapEdge(s.h), mapEdge(s.result)};
+        if (n.f < 0 || n.g < 0 || n.h < 0 || n.result < 0) continue;
+        Slot& dst = slots[hash(n.f, n.g, n.h) & mask];
+        if (dst.f < 0) ++used;
+        dst = n;
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Stats.h"
+
+// Fixed-size, lossy cache of ite(f, g, h) results. Each key maps to exactly one
+// slot and a newer result overwrites whatever was there, so a lookup is a single
+// probe and nothing ever needs to be evicted. Losing an entry only costs a
+// recomputation. The cache doubles, up to max_capacity, once more than half of
+// its slots are occupied.
+class ComputedCache {
+public:
+    explicit ComputedCache(size_t min_capacity = 1 << 12, size_t max_capacity = 1 << 22);
+
+    // Returns true and sets result if (f, g, h) is cached.
+    bool lookup(int f, int g, int h, int& result) {
+        const Slot& s = slots[hash(f, g, h) & mask];
+        if (s.f == f && s.g == g && s.h == h) {
+            STATS_INC(hit_count);
+            result = s.result;
+            return true;
+        }
+        STATS_INC(miss_count);
+        return false;
+    }
+
+    void insert(int f, int g, int h, int result) {
+        Slot& s = slots[hash(f, g, h) & mask];
+        if (s.f < 0) ++used;
+        s = {f, g, h, result};
+        if (used > grow_at && slots.size() < max_capacity) grow();
+    }
+
+    // Drops every entry and shrinks back to the minimum size. Counters are kept.
+    void clear();
+
+    // Renumbers the entries after the node table was compacted: node_map[id]
+    // is the new id of node id, or -1 if it was freed. Entries that mention a
+    // freed node are dropped; the others are rehashed under their new edges.
+    void remap(const std::vector<int>& node_map);
+
+    // Lookup counters for --stats (zero when built without ROBDD_STATS).
+    size_t hits() const { return hit_count; }
+    size_t misses() const { return miss_count; }
+    void resetStats() { hit_count = 0; miss_count = 0; }
+    size_t capacity() const { return slots.size(); }
+    size_t bytes() const { return slots.size() * sizeof(Slot); }
+
+private:
+    struct Slot {
+        int f; // -1 marks an empty slot
+        int g;
+        int h;
+        int result;
+    };
+
+    std::vector<Slot> slots; // power-of-two length
+    size_t mask = 0;
+    size_t used = 0;         // occupied slots
+    size_t grow_at = 0;
+    size_t min_capacity;
+    size_t max_capacity;
+    size_t hit_count = 0;
+    size_t miss_count = 0;
+
+    static size_t hash(int f, int g, int h) {
+        uint64_t x = (uint64_t)(uint32_t)f * 0x9E3779B97F4A7C15ULL;
+        x ^= (uint64_t)(uint32_t)g * 0xC2B2AE3D27D4EB4FULL;
+        x ^= (uint64_t)(uint32_t)h * 0x165667B19E3779F9ULL;
+        return (size_t)(x ^ (x >> 31));
+    }
+
+    void grow();
+};
@@ -0,0 +1,70 @@
+#include "DotWriter.h"
+#include <iostream>
+#ifdef ROBDD_ZLIB
+#include <zlib.h>
+#endif
+
+DotWriter::DotWriter(size_t buffer_bytes) : buf(buffer_bytes < 64 ? 64 : buffer_bytes) {}
+
+bool DotWriter::isGzipPath(const std::string& path) {
+    return path.size() >= 3 && path.compare(path.size() - 3, 3, ".gz") == 0;
+}
+
+bool DotWriter::open(const std::string& path) {
+    close();
+    failed = false;
+    if (isGzipPath(path)) {
+#ifdef ROBDD_ZLIB
+        gz = gzopen(path.c_str(), "wb1");
+        if (gz) {
+            gzbuffer((gzFile)gz, 1 << 18);
+            return true;
+        }
+#else
+        std::cerr << "Cannot write DOT file: " << path << " (built without zlib)" << std::endl;
+        return false;
+#endif
+    } else {
+        file = std::fopen(path.c_str(), "wb");
+        if (file) return true;
+    }
+    std::cerr << "Cannot write DOT file: " << path << std::endl;
+    return false;
+}
+
+void DotWriter::writeOut(const char* data, size_t n) {
+    if (failed || n == 0) return;
+#ifdef ROBDD_ZLIB
+    if (gz) {
+        // gzwrite takes an unsigned length; hand it at most 1 GiB at a time.
+        while (n > 0) {
+            unsigned chunk = (unsigned)(n < ((size_t)1 << 30) ? n : ((size_t)1 << 30));
+            if (gzwrite((gzFile)gz, data, chunk) != (int)chunk) {
+                failed = true;
+                return;
+            }
+            data += chunk;
+            n -= chunk;
+        }
+        return;
+    }
+#endif
+    if (!file || std::fwrite(data, 1, n, file) != n) failed = true;
+}
+
+void DotWriter::flush() {
+    writeOut(buf.data(), len);
+    len = 0;
+}
+
+bool DotWriter::close() {
+    if (!file && !gz) return !failed;
+    flush();
+#ifdef ROBDD_ZLIB
+    if (gz && gzclose((gzFile)gz) != Z_OK) failed = true;
+#endif
+    if (file && std::fclose(file) != 0) failed = true;
+    file = nullptr;
+    gz = nullptr;
+    return !failed;
+}
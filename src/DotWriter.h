@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Buffered text sink for the DOT writers. Tokens are appended to one reusable
+// buffer (integers formatted by hand, no locale or stream state) and the buffer
+// goes to the file in large blocks. A path ending in ".gz" is written gzip
+// compressed when the build has zlib (ROBDD_ZLIB, see the Makefile).
+class DotWriter {
+public:
+    explicit DotWriter(size_t buffer_bytes = 1 << 20);
+    ~DotWriter() { close(); }
+    DotWriter(const DotWriter&) = delete;
+    DotWriter& operator=(const DotWriter&) = delete;
+
+    // Opens path for writing. Returns false with a message if it cannot be
+    // opened, or if it asks for gzip and the build has no zlib.
+    bool open(const std::string& path);
+
+    // Flushes and closes the file. Returns false if any write failed.
+    bool close();
+
+    DotWriter& put(char c) {
+        if (len == buf.size()) flush();
+        buf[len++] = c;
+        return *this;
+    }
+
+    DotWriter& put(const char* s, size_t n) {
+        if (len + n > buf.size()) {
+            flush();
+            if (n > buf.size()) {
+                writeOut(s, n);
+                return *this;
+            }
+        }
+        for (size_t i = 0; i < n; ++i) buf[len + i] = s[i];
+        len += n;
+        return *this;
+    }
+
+    template <size_t N>
+    DotWriter& put(const char (&s)[N]) { return put(s, N - 1); }
+    DotWriter& put(const std::string& s) { return put(s.data(), s.size()); }
+
+    // Decimal digits of v.
+    DotWriter& num(uint64_t v) {
+        if (len + 20 > buf.size()) flush();
+        char tmp[20];
+        int n = 0;
+        do {
+            tmp[n++] = (char)('0' + v % 10);
+            v /= 10;
+        } while (v != 0);
+        while (n > 0) buf[len++] = tmp[--n];
+        return *this;
+    }
+
+    // True if path ends in ".gz".
+    static bool isGzipPath(const std::string& path);
+
+private:
+    void flush();
+    void writeOut(const char* data, size_t n);
+
+    std::vector<char> buf;
+    size_t len = 0;
+    FILE* file = nullptr;
+    void* gz = nullptr; // gzFile when writing compressed
+    bool failed = false;
+};
@@ -0,0 +1,319 @@
+#include "ParallelApply.h"
+#include <algorithm>
+#include <thread>
+
+static const int kDequeSize = 1 << 14;
+
+static size_t roundUpPow2(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+static size_t hashNode(int var_index, int else_id, int then_id) {
+    uint64_t h = (uint64_t)(uint32_t)else_id * 0x9E3779B97F4A7C15ULL;
+    h ^= ((uint64_t)(uint32_t)then_id << 32 | (uint32_t)var_index) * 0xC2B2AE3D27D4EB4FULL;
+    h ^= h >> 29;
+    return (size_t)h;
+}
+
+static size_t hashIte(int f, int g, int h) {
+    uint64_t x = (uint64_t)(uint32_t)f * 0x9E3779B97F4A7C15ULL;
+    x ^= (uint64_t)(uint32_t)g * 0xC2B2AE3D27D4EB4FULL;
+    x ^= (uint64_t)(uint32_t)h * 0x165667B19E3779F9ULL;
+    return (size_t)(x ^ (x >> 31));
+}
+
+static void lockWorker(std::atomic_flag& lock) {
+    while (lock.test_and_set(std::memory_order_acquire)) std::this_thread::yield();
+}
+
+static void unlockWorker(std::atomic_flag& lock) {
+    lock.clear(std::memory_order_release);
+}
+
+ParallelApply::ParallelApply(const std::vector<int>& var_order, int threads)
+    : var_order(var_order), var_level(var_order.size()), num_threads(std::max(1, threads)),
+      next_id(0), overflow(false), done(false) {
+    for (size_t l = 0; l < var_order.size(); ++l) var_level[var_order[l]] = (int)l;
+}
+
+size_t ParallelApply::getNodeCount() const {
+    return std::min(next_id.load(), limit);
+}
+
+// ---------------- Concurrent unique table ----------------
+
+// Returns the edge for (var, e, t), creating the node if needed. A new node is
+// written to its slot first and then published by a CAS on the bucket; if another
+// worker wins the bucket with the same triple, the written slot is abandoned.
+int ParallelApply::makeNode(int var_index, int else_id, int then_id) {
+    if (else_id == then_id) return else_id;
+    int neg = else_id & 1;
+    else_id ^= neg;
+    then_id ^= neg;
+
+    size_t i = hashNode(var_index, else_id, then_id) & bucket_mask;
+    int mine = -1;
+    for (;;) {
+        int id = buckets[i].load(std::memory_order_acquire);
+        if (id < 0) {
+            if (mine < 0) {
+                size_t slot = next_id.fetch_add(1, std::memory_order_relaxed);
+                if (slot >= limit) {
+                    overflow.store(true, std::memory_order_relaxed);
+                    return 0;
+                }
+                mine = (int)slot;
+                nodes[mine] = {else_id, then_id, var_index};
+            }
+            if (buckets[i].compare_exchange_strong(id, mine, std::memory_order_acq_rel)) {
+                return (mine << 1) | neg;
+            }
+            // Lost the race: id now holds the winner, compare against it below.
+        }
+        const Node& n = nodes[id];
+        if (n.else_id == else_id && n.then_id == then_id && n.var_index == var_index) {
+            return (id << 1) | neg;
+        }
+        i = (i + 1) & bucket_mask;
+    }
+}
+
+// ---------------- Concurrent computed cache ----------------
+
+bool ParallelApply::cacheLookup(int f, int g, int h, int& result) const {
+    const CacheSlot& s = cache[hashIte(f, g, h) & cache_mask];
+    unsigned seq = s.seq.load(std::memory_order_acquire);
+    if (seq & 1) return false;
+    int sf = s.f.load(std::memory_order_relaxed);
+    int sg = s.g.load(std::memory_order_relaxed);
+    int sh = s.h.load(std::memory_order_relaxed);
+    int sr = s.result.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (s.seq.load(std::memory_order_relaxed) != seq) return false;
+    if (sf != f || sg != g || sh != h) return false;
+    result = sr;
+    return true;
+}
+
+// Skips the insert if another worker is writing the same slot; the cache is lossy anyway.
+void ParallelApply::cacheInsert(int f, int g, int h, int result) {
+    CacheSlot& s = cache[hashIte(f, g, h) & cache_mask];
+    unsigned seq = s.seq.load(std::memory_order_relaxed);
+    if ((seq & 1) || !s.seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire)) return;
+    s.f.store(f, std::memory_order_relaxed);
+    s.g.store(g, std::memory_order_relaxed);
+    s.h.store(h, std::memory_order_relaxed);
+    s.result.store(result, std::memory_order_relaxed);
+    s.seq.store(seq + 2, std::memory_order_release);
+}
+
+// ---------------- Apply ----------------
+
+// Same normalization and recursion as RobddManager::ite, with the then-branch forked.
+int ParallelApply::ite(Worker& w, int f, int g, int h) {
+    if (overflow.load(std::memory_order_relaxed)) return 0;
+    if (f == 1) return g;
+    if (f == 0) return h;
+    if (g == f) g = 1; else if (g == (f ^ 1)) g = 0;
+    if (h == f) h = 0; else if (h == (f ^ 1)) h = 1;
+    if (g == h) return g;
+    if (g == 1 && h == 0) return f;
+    if (g == 0 && h == 1) return f ^ 1;
+
+    if (f & 1) { f ^= 1; std::swap(g, h); }
+    int neg = g & 1;
+    g ^= neg;
+    h ^= neg;
+
+    int cached;
+    if (cacheLookup(f, g, h, cached)) return cached ^ neg;
+
+    int lf = topLevel(f), lg = topLevel(g), lh = topLevel(h);
+    int lvl = std::min(lf, std::min(lg, lh));
+    int f0 = f, f1 = f, g0 = g, g1 = g, h0 = h, h1 = h;
+    if (lf == lvl) { f0 = elseOf(f); f1 = thenOf(f); }
+    if (lg == lvl) { g0 = elseOf(g); g1 = thenOf(g); }
+    if (lh == lvl) { h0 = elseOf(h); h1 = thenOf(h); }
+
+    bool forked = fork(w, TASK_ITE, f1, g1, h1);
+    int e = ite(w, f0, g0, h0);
+    int t = join(w, forked, TASK_ITE, f1, g1, h1);
+    int r = makeNode(var_order[lvl], e, t);
+    cacheInsert(f, g, h, r);
+    return r ^ neg;
+}
+
+int ParallelApply::cubeToBdd(const char* cube) {
+    int r = 1;
+    for (int lvl = (int)var_order.size() - 1; lvl >= 0; --lvl) {
+        int v = var_order[lvl];
+        switch (cube[v]) {
+            case '0': r = makeNode(v, r, 0); break;
+            case '1': r = makeNode(v, 0, r); break;
+            default: break;
+        }
+    }
+    return r;
+}
+
+// OR of cubes out_terms[k][lo, hi) as a balanced tree: both halves run in
+// parallel and are combined with one ite.
+int ParallelApply::orCubes(Worker& w, int k, int lo, int hi) {
+    if (hi - lo == 0) return 0;
+    if (hi - lo == 1) return cubeToBdd((*terms)[out_terms[k][lo]].cube);
+    int mid = lo + (hi - lo) / 2;
+    bool forked = fork(w, TASK_CUBES, k, mid, hi);
+    int a = orCubes(w, k, lo, mid);
+    int b = join(w, forked, TASK_CUBES, k, mid, hi);
+    return ite(w, a, 1, b);
+}
+
+void ParallelApply::buildOutputs(Worker& w, int lo, int hi) {
+    if (hi - lo == 1) {
+        roots[lo] = orCubes(w, lo, 0, (int)out_terms[lo].size());
+        return;
+    }
+    int mid = lo + (hi - lo) / 2;
+    bool forked = fork(w, TASK_OUTPUTS, mid, hi, 0);
+    buildOutputs(w, lo, mid);
+    join(w, forked, TASK_OUTPUTS, mid, hi, 0);
+}
+
+int ParallelApply::run(Worker& w, int kind, int a, int b, int c) {
+    switch (kind) {
+        case TASK_ITE: return ite(w, a, b, c);
+        case TASK_CUBES: return orCubes(w, a, b, c);
+        default: buildOutputs(w, a, b); return 0;
+    }
+}
+
+// ---------------- Work-stealing scheduler ----------------
+
+bool ParallelApply::fork(Worker& w, int kind, int a, int b, int c) {
+    if (num_threads == 1) return false;
+    lockWorker(w.lock);
+    if (w.tail == kDequeSize) {
+        unlockWorker(w.lock);
+        return false;
+    }
+    Task& t = w.tasks[w.tail++];
+    t.kind = kind;
+    t.a = a; t.b = b; t.c = c;
+    t.state.store(TASK_PENDING, std::memory_order_relaxed);
+    unlockWorker(w.lock);
+    return true;
+}
+
+// Pops the newest task if nobody stole it. Otherwise the task stays in its slot
+// until the thief is done, and meanwhile this worker runs tasks from the thief.
+int ParallelApply::join(Worker& w, bool forked, int kind, int a, int b, int c) {
+    if (!forked) return run(w, kind, a, b, c);
+    lockWorker(w.lock);
+    int idx = w.tail - 1;
+    if (w.head <= idx) {
+        w.tail = idx;
+        unlockWorker(w.lock);
+        return run(w, kind, a, b, c);
+    }
+    unlockWorker(w.lock);
+
+    Task& t = w.tasks[idx];
+    Worker& thief = *workers[t.thief];
+    while (t.state.load(std::memory_order_acquire) != TASK_DONE) {
+        if (!steal(w, thief)) std::this_thread::yield();
+    }
+    lockWorker(w.lock);
+    w.tail = idx;
+    w.head = idx;
+    unlockWorker(w.lock);
+    return t.result;
+}
+
+// Takes the oldest task of victim and runs it. Returns false if there was none.
+bool ParallelApply::steal(Worker& w, Worker& victim) {
+    if (&w == &victim) return false;
+    lockWorker(victim.lock);
+    if (victim.head >= victim.tail) {
+        unlockWorker(victim.lock);
+        return false;
+    }
+    Task& t = victim.tasks[victim.head++];
+    t.thief = w.id;
+    t.state.store(TASK_STOLEN, std::memory_order_relaxed);
+    int kind = t.kind, a = t.a, b = t.b, c = t.c;
+    unlockWorker(victim.lock);
+
+    ++w.steals;
+    t.result = run(w, kind, a, b, c);
+    t.state.store(TASK_DONE, std::memory_order_release);
+    return true;
+}
+
+void ParallelApply::workerLoop(Worker& w) {
+    while (!done.load(std::memory_order_acquire)) {
+        w.rng ^= w.rng << 13; w.rng ^= w.rng >> 7; w.rng ^= w.rng << 17;
+        Worker& victim = *workers[w.rng % workers.size()];
+        if (!steal(w, victim)) std::this_thread::yield();
+    }
+}
+
+// ---------------- Build ----------------
+
+bool ParallelApply::build(const PlaParser& parser, size_t capacity) {
+    // Fixed-size tables: nodes never move, so workers can read them without locks.
+    limit = capacity + 2;
+    nodes.assign(limit, Node{0, 0, -1});
+    nodes[1] = {1, 1, -1};
+    next_id.store(2);
+    overflow.store(false);
+
+    size_t nb = roundUpPow2(limit * 2); // load factor stays at or below 0.5
+    buckets.reset(new std::atomic<int>[nb]);
+    for (size_t i = 0; i < nb; ++i) buckets[i].store(-1, std::memory_order_relaxed);
+    bucket_mask = nb - 1;
+
+    size_t nc = std::min(roundUpPow2(limit), (size_t)1 << 22);
+    cache.reset(new CacheSlot[nc]);
+    for (size_t i = 0; i < nc; ++i) {
+        cache[i].seq.store(0, std::memory_order_relaxed);
+        cache[i].f.store(-1, std::memory_order_relaxed);
+    }
+    cache_mask = nc - 1;
+
+    terms = &parser.getProductTerms();
+    int num_outputs = parser.getNumOutputs();
+    out_terms.assign(num_outputs, std::vector<int>());
+    for (int k = 0; k < num_outputs; ++k) {
+        for (size_t i = 0; i < terms->size(); ++i) {
+            if ((*terms)[i].inOnSet(k)) out_terms[k].push_back((int)i);
+        }
+    }
+    roots.assign(num_outputs, 0);
+
+    workers.clear();
+    for (int i = 0; i < num_threads; ++i) {
+        std::unique_ptr<Worker> w(new Worker);
+        w->id = i;
+        w->tasks.reset(new Task[kDequeSize]);
+        w->rng = 0x9E3779B97F4A7C15ULL * (i + 1);
+        workers.push_back(std::move(w));
+    }
+
+    // The calling thread is worker 0 and runs the root task.
+    done.store(false);
+    std::vector<std::thread> threads;
+    for (int i = 1; i < num_threads; ++i) {
+        threads.emplace_back(&ParallelApply::workerLoop, this, std::ref(*workers[i]));
+    }
+    if (num_outputs > 0) buildOutputs(*workers[0], 0, num_outputs);
+    done.store(true, std::memory_order_release);
+    for (auto& th : threads) th.join();
+
+    steals = 0;
+    for (const auto& w : workers) steals += w->steals;
+    if (overflow.load()) return false;
+    nodes.resize(getNodeCount());
+    return true;
+}
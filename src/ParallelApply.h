@@ -0,0 +1,116 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "PlaParser.h"
+
+// Multi-threaded ROBDD construction in the style of Sylvan, used by
+// RobddManager::buildRobddParallel. Nodes and edges use the same encoding as
+// RobddManager ((id << 1) | complement, node 0 the terminal, id 1 reserved).
+//
+// - Nodes live in a fixed-capacity array shared by all workers; the unique
+//   table publishes a node id with one compare-and-swap, so lookups never lock.
+// - The ite cache is lossy and guarded per slot by a sequence counter.
+// - Each worker owns a task deque. ite() forks its then-recursion and runs the
+//   else-recursion itself; idle workers steal the oldest task of a random worker,
+//   and a worker waiting on a stolen task helps the thief (leapfrogging).
+// - The cubes of an output are ORed as a balanced tree of forked tasks.
+class ParallelApply {
+public:
+    struct Node {
+        int else_id;
+        int then_id;
+        int var_index;
+    };
+
+    // var_order: level -> variable index, as in RobddManager.
+    ParallelApply(const std::vector<int>& var_order, int threads);
+
+    // Builds one root per output with room for at most capacity nodes.
+    // Returns false if the capacity was exceeded; the caller retries larger.
+    bool build(const PlaParser& parser, size_t capacity);
+
+    // Node array (ids 0 .. getNodeCount()-1). Nodes lost in an insert race stay
+    // in the array unreferenced; a reduction pass drops them.
+    const std::vector<Node>& getNodes() const { return nodes; }
+    size_t getNodeCount() const;
+    const std::vector<int>& getRoots() const { return roots; }
+    size_t getSteals() const { return steals; }
+
+private:
+    enum TaskKind { TASK_ITE, TASK_CUBES, TASK_OUTPUTS };
+    enum TaskState { TASK_PENDING, TASK_STOLEN, TASK_DONE };
+
+    struct Task {
+        int kind;
+        int a, b, c;
+        int result;
+        int thief;
+        std::atomic<int> state;
+    };
+
+    struct Worker {
+        int id;
+        std::unique_ptr<Task[]> tasks;
+        int head = 0;            // oldest stealable task
+        int tail = 0;            // next free slot
+        std::atomic_flag lock = ATOMIC_FLAG_INIT;
+        uint64_t rng;
+        size_t steals = 0;
+    };
+
+    struct CacheSlot {
+        std::atomic<unsigned> seq; // odd while being written
+        std::atomic<int> f, g, h, result;
+    };
+
+    std::vector<int> var_order;
+    std::vector<int> var_level;
+    int num_threads;
+
+    std::vector<Node> nodes;
+    std::atomic<size_t> next_id;
+    size_t limit = 0;
+    std::atomic<bool> overflow;
+
+    std::unique_ptr<std::atomic<int>[]> buckets; // unique table: node id or -1
+    size_t bucket_mask = 0;
+
+    std::unique_ptr<CacheSlot[]> cache;
+    size_t cache_mask = 0;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<bool> done;
+    size_t steals = 0;
+
+    // Cube lists per output, the cubes themselves and the results.
+    std::vector<std::vector<int>> out_terms;
+    const std::vector<ProductTerm>* terms = nullptr;
+    std::vector<int> roots;
+
+    int topLevel(int e) const {
+        int v = nodes[e >> 1].var_index;
+        return v < 0 ? (int)var_order.size() : var_level[v];
+    }
+    int elseOf(int e) const { return nodes[e >> 1].else_id ^ (e & 1); }
+    int thenOf(int e) const { return nodes[e >> 1].then_id ^ (e & 1); }
+
+    int makeNode(int var_index, int else_id, int then_id);
+    bool cacheLookup(int f, int g, int h, int& result) const;
+    void cacheInsert(int f, int g, int h, int result);
+
+    int ite(Worker& w, int f, int g, int h);
+    int cubeToBdd(const char* cube);
+    int orCubes(Worker& w, int k, int lo, int hi);
+    void buildOutputs(Worker& w, int lo, int hi);
+
+    // Scheduler: fork() pushes a task (false if the deque is full, in which case
+    // join() runs it inline); join() returns the result of the newest forked task.
+    bool fork(Worker& w, int kind, int a, int b, int c);
+    int join(Worker& w, bool forked, int kind, int a, int b, int c);
+    bool steal(Worker& w, Worker& victim);
+    int run(Worker& w, int kind, int a, int b, int c);
+    void workerLoop(Worker& w);
+};
@@ -1,63 +1,212 @@
 #include "PlaParser.h"
-#include <fstream>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <string>
-#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-// Parses a PLA file line by line.
-bool PlaParser::parse(const std::string& filename){
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+// ---------------- Tokenizer ----------------
+
+struct Token {
+    const char* s;
+    size_t n;
+};
+
+static bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Returns the next whitespace-separated token of a line and advances p past it.
+// An empty token means the line is exhausted.
+static Token nextToken(const char*& p, const char* end) {
+    while (p < end && isBlank(*p)) ++p;
+    const char* s = p;
+    while (p < end && !isBlank(*p)) ++p;
+    return {s, (size_t)(p - s)};
+}
+
+static bool tokenIs(const Token& t, const char* word) {
+    size_t n = std::strlen(word);
+    return t.n == n && std::memcmp(t.s, word, n) == 0;
+}
+
+// Leading decimal digits of a token; 0 if there are none.
+static int tokenToInt(const Token& t) {
+    int v = 0;
+    for (size_t i = 0; i < t.n && t.s[i] >= '0' && t.s[i] <= '9'; ++i) v = v * 10 + (t.s[i] - '0');
+    return v;
+}
+
+// ---------------- Parser ----------------
+
+bool PlaParser::parse(const std::string& filename) {
+    return parseFile(filename, nullptr);
+}
+
+bool PlaParser::parse(const std::string& filename, const TermCallback& on_term) {
+    return parseFile(filename, &on_term);
+}
+
+// Maps the file read-only and scans it in place. Falls back to reading it into
+// memory where mmap is not possible (e.g. pipes).
+bool PlaParser::parseFile(const std::string& filename, const TermCallback* on_term) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
         std::cerr << "Error: cannot open " << filename << std::endl;
         return false;
     }
-    std::string line;
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string first_token;
-        ss >> first_token; // Read the first word, automatically skipping whitespace
 
-        // Skip empty lines and comments (lines starting with '#').
-        if (first_token.empty() || first_token[0] == '#') {
-            continue;
+    num_inputs = 0;
+    num_outputs = 0;
+    var_names.clear();
+    output_names.clear();
+    product_terms.clear();
+    cube_arena.clear();
+    output_arena.clear();
+    num_terms = 0;
+    bytes_parsed = 0;
+    lines_parsed = 0;
+
+    struct stat st;
+    void* map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        map = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    if (map != MAP_FAILED) {
+        madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+        const char* text = static_cast<const char*>(map);
+        parseText(text, text + st.st_size, on_term);
+        munmap(map, (size_t)st.st_size);
+    } else {
+        std::vector<char> buf;
+        char chunk[1 << 16];
+        ssize_t got;
+        while ((got = read(fd, chunk, sizeof(chunk))) > 0) buf.insert(buf.end(), chunk, chunk + got);
+        parseText(buf.data(), buf.data() + buf.size(), on_term);
+    }
+    close(fd);
+
+    // Name any outputs that .ob did not cover.
+    if (this->num_outputs == 0) this->num_outputs = 1;
+    for (int k = (int)output_names.size(); k < this->num_outputs; ++k) {
+        output_names.push_back("out" + std::to_string(k));
+    }
+    output_names.resize(this->num_outputs);
+
+    // Term views into the arenas, which no longer grow.
+    if (!on_term) {
+        bool multi = num_outputs > 1;
+        product_terms.resize(num_terms);
+        for (size_t i = 0; i < num_terms; ++i) {
+            product_terms[i].cube = cube_arena.data() + i * num_inputs;
+            product_terms[i].output = multi ? output_arena.data() + i * num_outputs : nullptr;
         }
-        
+    }
+    packCubes();
+    return true;
+}
+
+// Scans the PLA text line by line without copying lines or tokens.
+void PlaParser::parseText(const char* p, const char* end, const TermCallback* on_term) {
+    std::vector<char> term_cube, term_out; // the current term in streaming mode
+    bytes_parsed += end - p;
+    while (p < end) {
+        STATS_INC(lines_parsed);
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (!eol) eol = end;
+        const char* cur = p;
+        p = eol < end ? eol + 1 : end;
+
+        // Skip empty lines and comments (lines starting with '#').
+        Token first = nextToken(cur, eol);
+        if (first.n == 0 || first.s[0] == '#') continue;
+
         // Process lines starting with '.', which are PLA commands.
-        if (first_token[0] == '.') {
-            if (first_token == ".i") {
-                // .i: specifies the number of inputs.
-                ss >> this->num_inputs;
-                this->var_names.resize(this->num_inputs);
-            } else if (first_token == ".ilb") {
+        if (first.s[0] == '.') {
+            if (tokenIs(first, ".i")) {
+                // .i: specifies the number of inputs; fixed once terms are stored.
+                if (num_terms > 0) continue;
+                num_inputs = tokenToInt(nextToken(cur, eol));
+                var_names.resize(num_inputs);
+            } else if (tokenIs(first, ".o")) {
+                // .o: specifies the number of outputs.
+                if (num_terms > 0) continue;
+                num_outputs = tokenToInt(nextToken(cur, eol));
+            } else if (tokenIs(first, ".ob")) {
+                // .ob: specifies the names of the outputs.
+                for (Token t = nextToken(cur, eol); t.n > 0; t = nextToken(cur, eol)) output_names.emplace_back(t.s, t.n);
+            } else if (tokenIs(first, ".ilb")) {
                 // .ilb: specifies the names of the input variables.
                 for (size_t i = 0; i < var_names.size(); ++i) {
-                    ss >> var_names[i];
+                    Token t = nextToken(cur, eol);
+                    if (t.n == 0) break;
+                    var_names[i].assign(t.s, t.n);
                 }
-            } else if (first_token == ".p") {
+            } else if (tokenIs(first, ".p")) {
                 // .p: specifies the number of product terms. We reserve space for efficiency.
-                int num_products;
-                ss >> num_products;
-                this->product_terms.reserve(num_products);
-            } else if (first_token == ".e") {
+                size_t num_products = (size_t)tokenToInt(nextToken(cur, eol));
+                if (!on_term) {
+                    cube_arena.reserve(num_products * num_inputs);
+                    if (num_outputs > 1) output_arena.reserve(num_products * num_outputs);
+                }
+            } else if (tokenIs(first, ".e")) {
                 // .e: marks the end of the file.
                 break;
             }
-            // Other commands like .o, .type are ignored.
+            // Other commands like .type are ignored.
+            continue;
+        }
+
+        // If the line does not start with '.', it's a product term.
+        // The first token is the input cube, the second the output plane.
+        Token out = nextToken(cur, eol);
+        if (out.n == 0) continue;
+        if (num_outputs == 0) num_outputs = (int)out.n;
+
+        // We only care about on-sets, i.e., terms with a '1' in some output.
+        size_t no = std::min(out.n, (size_t)num_outputs);
+        if (!std::memchr(out.s, '1', no)) continue;
+        size_t nc = std::min(first.n, (size_t)num_inputs);
+        bool multi = num_outputs > 1;
+        ++num_terms;
+
+        if (on_term) {
+            term_cube.assign(first.s, first.s + nc);
+            term_cube.resize(num_inputs, '-');
+            term_out.assign(out.s, out.s + no);
+            term_out.resize(num_outputs, '0');
+            ProductTerm t = {term_cube.data(), multi ? term_out.data() : nullptr};
+            if (!(*on_term)(*this, t)) return;
         } else {
-            // If the line does not start with '.', it's a product term.
-            // The first token is the input cube.
-            std::string output;
-            ss >> output; // The second token is the output.
-            if (!output.empty()) {
-                // We only care about the on-set, i.e., terms where the output is '1'.
-                if (output == "1") {
-                    product_terms.push_back({first_token, output});
-                }
+            cube_arena.insert(cube_arena.end(), first.s, first.s + nc);
+            cube_arena.insert(cube_arena.end(), num_inputs - nc, '-');
+            if (multi) {
+                output_arena.insert(output_arena.end(), out.s, out.s + no);
+                output_arena.insert(output_arena.end(), num_outputs - no, '0');
             }
         }
     }
-    file.close();
-    return true;
+}
+
+// Fills cube_matrix from product_terms (empty in streaming mode).
+void PlaParser::packCubes() {
+    CubeMatrix& m = cube_matrix;
+    m.num_cubes = (int)product_terms.size();
+    m.words = (m.num_cubes + 63) / 64;
+    m.care.assign((size_t)num_inputs * m.words, 0);
+    m.value.assign((size_t)num_inputs * m.words, 0);
+    for (int i = 0; i < m.num_cubes; ++i) {
+        const char* cube = product_terms[i].cube;
+        uint64_t bit = 1ULL << (i % 64);
+        for (int v = 0; v < num_inputs; ++v) {
+            size_t w = (size_t)v * m.words + i / 64;
+            if (cube[v] == '0' || cube[v] == '1') m.care[w] |= bit;
+            if (cube[v] == '1') m.value[w] |= bit;
+        }
+    }
 }
 
 // Getter for the number of inputs.
@@ -65,12 +214,27 @@ int PlaParser::getNumInputs() const {
     return this->num_inputs;
 }
 
+// Getter for the number of outputs.
+int PlaParser::getNumOutputs() const {
+    return this->num_outputs;
+}
+
 // Getter for the input variable names.
 const std::vector<std::string>& PlaParser::getInputNames() const {
     return this->var_names;
 }
 
+// Getter for the output names.
+const std::vector<std::string>& PlaParser::getOutputNames() const {
+    return this->output_names;
+}
+
 // Getter for the product terms.
 const std::vector<ProductTerm>& PlaParser::getProductTerms() const {
     return product_terms;
-}
\ No newline at end of file
+}
+
+// Getter for the bit-packed product terms.
+const CubeMatrix& PlaParser::getCubeMatrix() const {
+    return cube_matrix;
+}
@@ -1,27 +1,88 @@
 #pragma once
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
+#include "Stats.h"
 
-// Represents a single product term in a PLA file, like "1-01 1".
+// Represents a single product term in a PLA file, like "1-01 10".
+// A view into the parser's arena; the characters are not NUL-terminated.
 struct ProductTerm {
-    std::string cube;   // The input part, e.g., "1-01"
-    std::string output; // The output part, e.g., "1"
+    const char* cube;   // The input part, exactly getNumInputs() literals, e.g., "1-01"
+    const char* output; // The output plane, getNumOutputs() characters, e.g., "10";
+                        // null for single-output PLAs, where every stored term is in the on-set
+
+    // True if this cube belongs to the on-set of output k.
+    bool inOnSet(int k) const { return output ? output[k] == '1' : k == 0; }
+};
+
+// Bit-packed copy of the product terms, laid out column-major: the bits of
+// input v are the words [v * words, (v + 1) * words), with cube i at bit i % 64
+// of word i / 64. care marks a '0' or '1' literal, value marks a '1'.
+struct CubeMatrix {
+    int num_cubes = 0;
+    int words = 0; // 64-bit words per column
+    std::vector<uint64_t> care;
+    std::vector<uint64_t> value;
+
+    const uint64_t* careColumn(int v) const { return care.data() + (size_t)v * words; }
+    const uint64_t* valueColumn(int v) const { return value.data() + (size_t)v * words; }
 };
 
 // A parser for simplified PLA (Programmable Logic Array) files.
-// It extracts the number of inputs, variable names, and product terms that result in a '1' output.
+// It extracts the number of inputs and outputs, their names, and the product
+// terms that have a '1' in at least one output.
+//
+// The file is memory-mapped and scanned in place. Cube literals and output
+// planes are copied into one contiguous arena each; short cubes are padded with
+// '-' and short output planes with '0'.
 class PlaParser{
 public:
+    // Called once per on-set term in streaming mode. The header getters are
+    // valid from the first call; the term is only valid during the call.
+    // Returning false stops parsing.
+    typedef std::function<bool(const PlaParser&, const ProductTerm&)> TermCallback;
+
+    PlaParser() = default;
+    PlaParser(const PlaParser&) = delete; // terms point into the arena
+    PlaParser& operator=(const PlaParser&) = delete;
+
     // Parses the given PLA file.
     // Returns true on success, false on failure (e.g., file not found).
     bool parse(const std::string& filename);
 
+    // Streaming mode: hands each term to on_term instead of storing it, so the
+    // term list is never resident. getProductTerms() stays empty.
+    bool parse(const std::string& filename, const TermCallback& on_term);
+
+    // Number of on-set terms seen by the last parse (stored or streamed).
+    size_t getNumTerms() const { return num_terms; }
+
+    // Input size of the last parse; lines are only counted with ROBDD_STATS.
+    size_t getBytesParsed() const { return bytes_parsed; }
+    size_t getLinesParsed() const { return lines_parsed; }
+
     // Getters for the parsed data.
     int getNumInputs() const;
+    int getNumOutputs() const;
     const std::vector<std::string>& getInputNames() const;
+    const std::vector<std::string>& getOutputNames() const;
     const std::vector<ProductTerm>& getProductTerms() const;
+    const CubeMatrix& getCubeMatrix() const;
 private:
     int num_inputs = 0; // Number of input variables (from .i line).
+    int num_outputs = 0; // Number of outputs (from .o line, or the first term's output plane).
     std::vector<std::string> var_names; // Names of input variables (from .ilb line).
-    std::vector<ProductTerm> product_terms; // List of product terms with a '1' in their output.
+    std::vector<std::string> output_names; // Names of outputs (from .ob line).
+    std::vector<ProductTerm> product_terms; // List of product terms with a '1' in some output.
+    std::vector<char> cube_arena;   // num_inputs literals per term
+    std::vector<char> output_arena; // num_outputs characters per term (multi-output only)
+    size_t num_terms = 0;
+    size_t bytes_parsed = 0;
+    size_t lines_parsed = 0;
+    CubeMatrix cube_matrix; // The same terms, bit-packed.
+
+    bool parseFile(const std::string& filename, const TermCallback* on_term);
+    void parseText(const char* p, const char* end, const TermCallback* on_term);
+    void packCubes();
 };
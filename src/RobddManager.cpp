@@ -1,4 +1,7 @@
 #include "RobddManager.h"
+#include "ParallelApply.h"
+#include "DotWriter.h"
+#include "TruthTable.h"
 #include <algorithm>
 #include <fstream>
 #include <iostream>
@@ -8,294 +11,1483 @@
 #include <queue>
 #include <unordered_map>
 #include <cmath>
+#include <chrono>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Node 0 is the terminal (FALSE as a regular edge, TRUE complemented).
+// Slot 1 only keeps internal ids starting at 2 and is never referenced.
+void RobddManager::resetNodes() {
+    if (spare_nodes.capacity() > nodes.capacity()) nodes.swap(spare_nodes); // build in the larger buffer
+    nodes.clear();
+    table_full = false;
+    unique_table.clear();
+    computed_table.clear();
+    std::fill(ref_edges.begin(), ref_edges.end(), 0); // Refs into the old table read FALSE
+    nodes.push_back({0, 0, -1}); // terminal
+    nodes.push_back({1, 1, -1}); // reserved
+}
 
 // Creates a new node or returns an existing one if an identical node already exists.
 // This function is the heart of the "reduction" in ROBDD.
 int RobddManager::makeNode(int var_index, int else_id, int then_id) {
     // Reduction Rule 1: Eliminate redundant tests.
     if (else_id == then_id) return else_id;
+    if (nodes.size() >= kMaxNodes) { // the build fails; unwind with FALSE
+        table_full = true;
+        return 0;
+    }
 
-    // Reduction Rule 2: Merge isomorphic nodes.
-    long long key = makeKey(var_index, else_id, then_id);
-    auto it = unique_table.find(key);
-    if (it != unique_table.end()) return it->second;
+    // Complement edges: keep the else edge regular, so f and !f share one node.
+    int neg = else_id & 1;
+    else_id ^= neg;
+    then_id ^= neg;
 
-    int id = (int)nodes.size();
-    nodes.push_back({id, var_index, else_id, then_id, -1});
-    unique_table[key] = id;
-    return id;
+    // Reduction Rule 2: Merge isomorphic nodes.
+    int id = unique_table.findOrInsert(var_index, else_id, then_id, (int)nodes.size());
+    if (id == (int)nodes.size()) {
+        nodes.push_back({else_id, then_id, var_index});
+        STATS_INC(stats.nodes_created);
+    }
+    return (id << 1) | neg;
 }
 
 // Always create a node without using unique table (used during OBDD construction).
-int RobddManager::makeNodeNoReduce(int var_index, int else_id, int then_id, int obdd_index) {
+int RobddManager::makeNodeNoReduce(int var_index, int else_id, int then_id) {
+    if (nodes.size() >= kMaxNodes) {
+        table_full = true;
+        return 0;
+    }
     int id = (int)nodes.size();
-    nodes.push_back({id, var_index, else_id, then_id, obdd_index});
-    return id;
+    nodes.push_back({else_id, then_id, var_index});
+    STATS_INC(stats.nodes_created);
+    return id << 1;
 }
 
 // ---------------- OBDD builder (no on-the-fly reduction) ----------------
-int RobddManager::buildObddRec(int var_index, const std::vector<int>& term_indices, const PlaParser& parser, int cur_obdd_index) {
-    int n = parser.getNumInputs();
 
-    // Base case: at the leaf level. Check if any term covers this path.
-    if (var_index == n) {
-        return term_indices.empty() ? 0 : 1;
+// Splits the cube set `in` on one input, 64 cubes per word: a cube stays in the
+// else set unless its literal is '1' and in the then set unless it is '0'.
+// Only words [lo, hi) are read and written.
+static void partitionCubes(const uint64_t* care, const uint64_t* value, const uint64_t* in,
+                           uint64_t* out_else, uint64_t* out_then, int lo, int hi) {
+    int w = lo;
+#ifdef __AVX2__
+    for (; w + 4 <= hi; w += 4) {
+        __m256i c = _mm256_loadu_si256((const __m256i*)(care + w));
+        __m256i x = _mm256_loadu_si256((const __m256i*)(value + w));
+        __m256i s = _mm256_loadu_si256((const __m256i*)(in + w));
+        __m256i one = _mm256_and_si256(c, x);
+        __m256i zero = _mm256_andnot_si256(x, c);
+        _mm256_storeu_si256((__m256i*)(out_else + w), _mm256_andnot_si256(one, s));
+        _mm256_storeu_si256((__m256i*)(out_then + w), _mm256_andnot_si256(zero, s));
     }
+#endif
+    for (; w < hi; ++w) {
+        uint64_t one = care[w] & value[w];
+        uint64_t zero = care[w] & ~value[w];
+        out_else[w] = in[w] & ~one;
+        out_then[w] = in[w] & ~zero;
+    }
+}
 
-    // Partition by current variable
-    std::vector<int> else_terms; else_terms.reserve(term_indices.size());
-    std::vector<int> then_terms; then_terms.reserve(term_indices.size());
-    const auto& terms = parser.getProductTerms();
-    for (int idx : term_indices) {
-        char literal = terms[idx].cube[var_index];
-        switch (literal) {
-            case '-': else_terms.push_back(idx); then_terms.push_back(idx); break;
-            case '0': else_terms.push_back(idx); break;
-            case '1': then_terms.push_back(idx); break;
-            default: break;
-        }
+// Narrows [lo, hi) to the non-zero words of a cube set; lo == hi means empty.
+static void trimCubes(const uint64_t* set, int& lo, int& hi) {
+    while (lo < hi && set[lo] == 0) ++lo;
+    while (hi > lo && set[hi - 1] == 0) --hi;
+}
+
+int RobddManager::buildObddRec(int level, const uint64_t* cubes, int lo, int hi, const CubeMatrix& m) {
+    int n = (int)var_order.size();
+    STATS_MAX(stats.max_depth, level + 1);
+
+    // Base case: at the leaf level. Check if any term covers this path.
+    if (level == n) {
+        return lo < hi ? 1 : 0;
     }
 
-    int else_id = buildObddRec(var_index + 1, else_terms, parser, cur_obdd_index * 2);
-    int then_id = buildObddRec(var_index + 1, then_terms, parser, cur_obdd_index * 2 + 1);
+    // Partition by the variable decided at this level
+    int var_index = var_order[level];
+    uint64_t* else_cubes = cube_sets.data() + (size_t)(2 * level) * m.words; // words may be 0
+    uint64_t* then_cubes = else_cubes + m.words;
+    partitionCubes(m.careColumn(var_index), m.valueColumn(var_index), cubes, else_cubes, then_cubes, lo, hi);
+    int else_lo = lo, else_hi = hi, then_lo = lo, then_hi = hi;
+    trimCubes(else_cubes, else_lo, else_hi);
+    trimCubes(then_cubes, then_lo, then_hi);
+
+    int else_id = buildObddRec(level + 1, else_cubes, else_lo, else_hi, m);
+    int then_id = buildObddRec(level + 1, then_cubes, then_lo, then_hi, m);
 
-    // Always create a node to form a full tree, with its OBDD index assigned.
-    return makeNodeNoReduce(var_index, else_id, then_id, cur_obdd_index);
+    // Always create a node to form a full tree; the writer derives its OBDD index.
+    return makeNodeNoReduce(var_index, else_id, then_id);
+}
+
+bool RobddManager::checkNodeLimit() const {
+    if (!table_full) return true;
+    std::cerr << "[Error] The node table exceeds " << kMaxNodes << " nodes." << std::endl;
+    return false;
+}
+
+bool RobddManager::obddFits(int num_inputs, int num_outputs) {
+    if (num_inputs + 1 >= 63) return false;
+    size_t per_output = (size_t)1 << (num_inputs + 1);
+    return per_output <= kMaxObddNodes / std::max(1, num_outputs);
 }
 
 // Initializes and starts the OBDD construction process.
 bool RobddManager::buildObddFromPla(const PlaParser& parser) {
-    nodes.clear();
-    unique_table.clear();
+    if (!obddFits(parser.getNumInputs(), parser.getNumOutputs())) {
+        std::cerr << "[Error] The OBDD tree for " << parser.getNumInputs() << " inputs exceeds "
+                  << kMaxObddNodes << " nodes." << std::endl;
+        return false;
+    }
+    resetNodes();
     var_names = parser.getInputNames();
-
-    // terminals
-    nodes.push_back({0, -1, 0, 0, -1}); // 0
-    nodes.push_back({1, -1, 1, 1, -1}); // 1
+    output_names = parser.getOutputNames();
+    roots.clear();
+    resetVarOrder();
 
     int nVars = parser.getNumInputs();
-    int expected_nodes = (1 << (nVars + 1)); // rough estimate
-    nodes.reserve(expected_nodes);
+    int nOut = parser.getNumOutputs();
+    nodes.reserve((size_t)nOut << (nVars + 1)); // rough estimate; obddFits bounds it
 
-    std::vector<int> all_terms;
+    // One full tree per output, each over the terms in that output's on-set.
     const auto& pts = parser.getProductTerms();
-    all_terms.reserve(pts.size());
-    for (size_t i = 0; i < pts.size(); ++i) all_terms.push_back((int)i);
-
-    root_id = buildObddRec(0, all_terms, parser, 1);
+    const CubeMatrix& m = parser.getCubeMatrix();
+    cube_sets.assign((size_t)2 * nVars * m.words, 0);
+    std::vector<uint64_t> on_cubes(m.words);
+    for (int k = 0; k < nOut; ++k) {
+        std::fill(on_cubes.begin(), on_cubes.end(), 0);
+        for (size_t i = 0; i < pts.size(); ++i) {
+            if (pts[i].inOnSet(k)) on_cubes[i / 64] |= 1ULL << (i % 64);
+        }
+        int lo = 0, hi = m.words;
+        trimCubes(on_cubes.data(), lo, hi);
+        roots.push_back(buildObddRec(0, on_cubes.data(), lo, hi, m));
+    }
+    std::vector<uint64_t>().swap(cube_sets);
+    noteTableBytes();
     return true;
 }
 
-// Reduce an already built OBDD to an ROBDD.
-int RobddManager::reduceRec(int old_id,
+// Reference reducer: recursive, hash-based. Kept to cross-check reduceToRobdd.
+// Maps an old edge to its reduced edge; map_old_to_new is keyed by old node id.
+int RobddManager::reduceRec(int old_edge,
                             std::unordered_map<int,int>& map_old_to_new,
-                            std::unordered_map<long long,int>& uniq,
+                            UniqueTable& uniq,
                             std::vector<Node>& new_nodes) {
-    // If this old_id has been processed, return its new mapped id.
-    auto it = map_old_to_new.find(old_id);
-    if (it != map_old_to_new.end()) return it->second;
+    int old_id = old_edge >> 1;
+    int neg = old_edge & 1;
 
-    // Terminals map to themselves (fixed new IDs 0 and 1)
-    if (old_id == 0) return 0;
-    if (old_id == 1) return 1;
+    // The terminal maps to itself (fixed new ID 0)
+    if (old_id == 0) return old_edge;
 
-    const Node& cur = nodes[old_id];
+    // If this old_id has been processed, return its new mapped edge.
+    auto it = map_old_to_new.find(old_id);
+    if (it != map_old_to_new.end()) return it->second ^ neg;
+
+    const Node cur = nodes[old_id];
     int new_else = reduceRec(cur.else_id, map_old_to_new, uniq, new_nodes);
     int new_then = reduceRec(cur.then_id, map_old_to_new, uniq, new_nodes);
 
     // Rule 1: remove redundant tests
     if (new_else == new_then) {
         map_old_to_new[old_id] = new_else;
-        return new_else;
+        return new_else ^ neg;
     }
 
-    // Rule 2: merge isomorphic nodes
-    long long key = makeKey(cur.var_index, new_else, new_then);
-    auto uit = uniq.find(key);
-    if (uit != uniq.end()) {
-        map_old_to_new[old_id] = uit->second;
-        return uit->second;
-    }
+    // Keep the else edge regular
+    int c = new_else & 1;
+    new_else ^= c;
+    new_then ^= c;
 
-    // Create reduced node and preserve OBDD index
-    int new_id = (int)new_nodes.size();
-    new_nodes.push_back({new_id, cur.var_index, new_else, new_then, cur.obdd_index});
-    uniq[key] = new_id;
-    map_old_to_new[old_id] = new_id;
-    return new_id;
+    // Rule 2: merge isomorphic nodes; otherwise create the reduced node
+    int new_id = uniq.findOrInsert(cur.var_index, new_else, new_then, (int)new_nodes.size());
+    if (new_id == (int)new_nodes.size()) new_nodes.push_back({new_else, new_then, cur.var_index});
+    map_old_to_new[old_id] = (new_id << 1) | c;
+    return map_old_to_new[old_id] ^ neg;
 }
 
+// Bryant's linear-time reduction. Reachable nodes are bucketed by level and the
+// levels are processed bottom-up without recursion. The old -> new map is a flat
+// vector indexed by node id, and isomorphic nodes are merged by sorting each
+// level on (else, then) instead of probing a global hash table.
 bool RobddManager::reduceToRobdd() {
     if (nodes.empty()) return false;
+    int nVars = (int)var_names.size();
+    size_t N = nodes.size();
 
-    // Prepare new container with terminals copied at fixed ids 0 and 1
+    // Mark the nodes reachable from the roots and count them per level.
+    std::vector<int> remap(N, -1); // old id -> new edge; -2 marks "reachable, not yet mapped"
+    std::vector<int> level_start(nVars + 1, 0);
+    std::vector<int> stack;
+    auto markRoot = [&](int r) {
+        if (r >= 2 && remap[r >> 1] == -1) { remap[r >> 1] = -2; stack.push_back(r >> 1); }
+    };
+    for (int r : roots) markRoot(r);
+    for (int r : ref_edges) markRoot(r); // freed slots hold FALSE
+    while (!stack.empty()) {
+        int id = stack.back(); stack.pop_back();
+        const Node& nd = nodes[id];
+        ++level_start[var_level[nd.var_index] + 1];
+        int kids[2] = {nd.else_id >> 1, nd.then_id >> 1};
+        for (int c : kids) {
+            if (c >= 2 && remap[c] == -1) { remap[c] = -2; stack.push_back(c); }
+        }
+    }
+    for (int l = 0; l < nVars; ++l) level_start[l + 1] += level_start[l];
+
+    // Counting sort into one flat array of per-level buckets.
+    std::vector<int> bucket(level_start[nVars]);
+    std::vector<int> fill(level_start.begin(), level_start.end() - 1);
+    for (size_t id = 2; id < N; ++id) {
+        if (remap[id] == -2) bucket[fill[var_level[nodes[id].var_index]]++] = (int)id;
+    }
+
+    // Prepare new container with the terminal and the reserved slot, reusing
+    // the storage the previous reduction left behind.
+    std::vector<Node> new_nodes;
+    new_nodes.swap(spare_nodes);
+    new_nodes.clear();
+    new_nodes.reserve(bucket.size() + 2);
+    new_nodes.push_back({0, 0, -1});
+    new_nodes.push_back({1, 1, -1});
+    remap[0] = 0;
+    auto mapEdge = [&](int e) { return remap[e >> 1] ^ (e & 1); };
+
+    struct Entry { int e, t, neg, old_id; };
+    std::vector<Entry> level_nodes;
+    for (int l = nVars - 1; l >= 0; --l) {
+        level_nodes.clear();
+        for (int k = level_start[l]; k < level_start[l + 1]; ++k) {
+            int old_id = bucket[k];
+            const Node& cur = nodes[old_id];
+            int new_else = mapEdge(cur.else_id);
+            int new_then = mapEdge(cur.then_id);
+
+            // Rule 1: remove redundant tests
+            if (new_else == new_then) { remap[old_id] = new_else; continue; }
+
+            // Keep the else edge regular; the node then stands for !f.
+            int neg = new_else & 1;
+            level_nodes.push_back({new_else ^ neg, new_then ^ neg, neg, old_id});
+        }
+
+        // Rule 2: merge isomorphic nodes
+        std::sort(level_nodes.begin(), level_nodes.end(), [](const Entry& a, const Entry& b) {
+            if (a.e != b.e) return a.e < b.e;
+            return a.t < b.t;
+        });
+        int var_index = var_order[l];
+        for (size_t k = 0; k < level_nodes.size(); ++k) {
+            const Entry& en = level_nodes[k];
+            if (k == 0 || en.e != level_nodes[k - 1].e || en.t != level_nodes[k - 1].t) {
+                new_nodes.push_back({en.e, en.t, var_index});
+            }
+            remap[en.old_id] = (((int)new_nodes.size() - 1) << 1) | en.neg;
+        }
+    }
+
+    for (int& r : roots) r = mapEdge(r);
+    for (int& r : ref_edges) r = mapEdge(r);
+    // Carry the computed cache over to the new ids; entries on nodes that
+    // became a complemented edge are dropped.
+    for (size_t id = 0; id < N; ++id) remap[id] = remap[id] < 0 || (remap[id] & 1) ? -1 : remap[id] >> 1;
+    computed_table.remap(remap);
+    noteTableBytes(new_nodes.capacity() * sizeof(Node));
+    nodes.swap(new_nodes);
+    spare_nodes.swap(new_nodes); // kept for the next build on this manager
+
+    // Rebuild the unique table over the surviving nodes for later makeNode calls.
+    // Reduced nodes are distinct, so no lookups are needed.
+    unique_table.clear();
+    unique_table.reserve(nodes.size());
+    for (size_t id = 2; id < nodes.size(); ++id) {
+        const Node& nd = nodes[id];
+        unique_table.insertNew(nd.var_index, nd.else_id, nd.then_id, (int)id);
+    }
+    return true;
+}
+
+bool RobddManager::reduceToRobddReference() {
+    if (nodes.empty()) return false;
+
+    // Prepare new container with the terminal and the reserved slot
     std::vector<Node> new_nodes;
     new_nodes.reserve(nodes.size());
-    new_nodes.push_back({0, -1, 0, 0, -1});
-    new_nodes.push_back({1, -1, 1, 1, -1});
+    new_nodes.push_back({0, 0, -1});
+    new_nodes.push_back({1, 1, -1});
 
-    std::unordered_map<int,int> map_old_to_new; // old id -> new id
-    std::unordered_map<long long,int> uniq; // unique table for reduced graph
+    std::unordered_map<int,int> map_old_to_new; // old id -> new edge
+    UniqueTable uniq; // unique table shared by all outputs
 
-    int new_root = reduceRec(root_id, map_old_to_new, uniq, new_nodes);
+    for (int& r : roots) r = reduceRec(r, map_old_to_new, uniq, new_nodes);
 
     nodes.swap(new_nodes);
     unique_table = std::move(uniq);
-    root_id = new_root;
     return true;
 }
 
+bool RobddManager::sameGraph(const RobddManager& other) const {
+    if (var_order != other.var_order || roots.size() != other.roots.size()) return false;
+    std::vector<int> match(nodes.size(), -1); // this id -> other id
+    match[0] = 0;
+    std::vector<std::pair<int,int>> stack; // (this edge, other edge)
+    for (size_t k = 0; k < roots.size(); ++k) stack.push_back({roots[k], other.roots[k]});
+    while (!stack.empty()) {
+        std::pair<int,int> p = stack.back(); stack.pop_back();
+        if ((p.first & 1) != (p.second & 1)) return false;
+        int a = p.first >> 1, b = p.second >> 1;
+        if (a >= (int)nodes.size() || b >= (int)other.nodes.size()) return false;
+        if (match[a] >= 0) {
+            if (match[a] != b) return false;
+            continue;
+        }
+        if (a == 0 || b == 0) return false; // the terminal only matches itself
+        const Node& x = nodes[a];
+        const Node& y = other.nodes[b];
+        if (x.var_index != y.var_index) return false;
+        match[a] = b;
+        stack.push_back({x.else_id, y.else_id});
+        stack.push_back({x.then_id, y.then_id});
+    }
+    return getNodeCount() == other.getNodeCount();
+}
+
 // Convenience wrapper: build OBDD then reduce to ROBDD
 bool RobddManager::buildFromPla(const PlaParser& parser) {
     if (!buildObddFromPla(parser)) return false;
     return reduceToRobdd();
 }
 
+// ---------------- Direct ROBDD builder (apply/ite engine) ----------------
+
+// Returns the level of the variable tested by an edge; terminals sit below every level.
+int RobddManager::topLevel(int e) const {
+    int v = nodes[e >> 1].var_index;
+    return v < 0 ? (int)var_names.size() : var_level[v];
+}
+
+// If-then-else: returns the node for (f & g) | (!f & h). The top-level call is
+// the only point where a collection may run, since no recursion is in flight.
+int RobddManager::ite(int f, int g, int h) {
+    if (gcDue()) {
+        int ops[3] = {f, g, h};
+        collect(ops, 3);
+        f = ops[0];
+        g = ops[1];
+        h = ops[2];
+    }
+    return iteRec(f, g, h);
+}
+
+int RobddManager::iteRec(int f, int g, int h) {
+    // Terminal cases.
+    if (f == 1) return g;
+    if (f == 0) return h;
+    if (g == f) g = 1; else if (g == (f ^ 1)) g = 0;
+    if (h == f) h = 0; else if (h == (f ^ 1)) h = 1;
+    if (g == h) return g;
+    if (g == 1 && h == 0) return f;
+    if (g == 0 && h == 1) return f ^ 1;
+
+    // Normalize so equivalent calls share one cache entry:
+    // ite(!f,g,h) = ite(f,h,g) and ite(f,!g,!h) = !ite(f,g,h).
+    if (f & 1) { f ^= 1; std::swap(g, h); }
+    int neg = g & 1;
+    g ^= neg;
+    h ^= neg;
+
+    int cached;
+    if (computed_table.lookup(f, g, h, cached)) return cached ^ neg;
+    STATS_INC(depth);
+    STATS_MAX(stats.max_depth, depth);
+
+    // Split on the topmost level among the three operands.
+    int lvl = std::min(topLevel(f), std::min(topLevel(g), topLevel(h)));
+    int f0 = f, f1 = f, g0 = g, g1 = g, h0 = h, h1 = h;
+    if (topLevel(f) == lvl) { f0 = elseOf(f); f1 = thenOf(f); }
+    if (topLevel(g) == lvl) { g0 = elseOf(g); g1 = thenOf(g); }
+    if (topLevel(h) == lvl) { h0 = elseOf(h); h1 = thenOf(h); }
+
+    int e = iteRec(f0, g0, h0);
+    int t = iteRec(f1, g1, h1);
+    int r = makeNode(var_order[lvl], e, t);
+    computed_table.insert(f, g, h, r);
+    STATS_DEC(depth);
+    return r ^ neg;
+}
+
+// Builds the conjunction of a cube's literals bottom-up, one node per care bit.
+int RobddManager::cubeToBdd(const char* cube) {
+    int r = 1;
+    for (int lvl = (int)var_order.size() - 1; lvl >= 0; --lvl) {
+        int v = var_order[lvl];
+        switch (cube[v]) {
+            case '0': r = makeNode(v, r, 0); break;
+            case '1': r = makeNode(v, 0, r); break;
+            default: break; // '-' does not constrain this variable
+        }
+    }
+    return r;
+}
+
+bool RobddManager::buildRobddFromPla(const PlaParser& parser) {
+    GcHold hold(*this);
+    resetNodes();
+    var_names = parser.getInputNames();
+    output_names = parser.getOutputNames();
+    roots.clear();
+    resetVarOrder();
+
+    // Cube BDDs are built once and shared by every output that uses them.
+    const auto& pts = parser.getProductTerms();
+    std::vector<int> cube_bdd(pts.size(), -1);
+    for (int k = 0; k < parser.getNumOutputs(); ++k) {
+        int f = 0;
+        for (size_t i = 0; i < pts.size() && f != 1; ++i) { // stop at a tautology
+            if (!pts[i].inOnSet(k)) continue;
+            if (cube_bdd[i] < 0) cube_bdd[i] = cubeToBdd(pts[i].cube);
+            f = bddOr(f, cube_bdd[i]);
+        }
+        roots.push_back(f);
+    }
+
+    // The cache only helps while building; drop it to release memory.
+    noteTableBytes();
+    computed_table.clear();
+    if (!checkNodeLimit()) return false;
+
+    // Intermediate cubes and partial sums are left unreachable in the table;
+    // a reduction pass over the (already reduced) graph compacts them away.
+    return reduceToRobdd();
+}
+
+// ---------------- Truth-table builder (small input counts) ----------------
+
+template <int W>
+void RobddManager::buildFromTruthTables(const PlaParser& parser) {
+    int n = (int)var_names.size();
+    int nOut = (int)output_names.size();
+    size_t bits = (size_t)1 << n;
+
+    // Evaluate the cube list: one in-word mask and one word selector per cube.
+    uint64_t all = n >= 6 ? ~0ULL : (1ULL << bits) - 1;
+    std::vector<TruthTable<W>> tables(nOut);
+    for (auto& t : tables) t.clear();
+    for (const ProductTerm& term : parser.getProductTerms()) {
+        uint64_t in_word = all, hi_care = 0, hi_value = 0;
+        for (int v = 0; v < n; ++v) {
+            char c = term.cube[v];
+            if (c != '0' && c != '1') continue;
+            int b = n - 1 - var_level[v];
+            if (b < 6) {
+                in_word &= c == '1' ? kTruthPattern[b] : ~kTruthPattern[b];
+            } else {
+                hi_care |= 1ULL << (b - 6);
+                if (c == '1') hi_value |= 1ULL << (b - 6);
+            }
+        }
+        if (in_word == 0) continue;
+        for (int k = 0; k < nOut; ++k) {
+            if (term.inOnSet(k)) tables[k].orCube(in_word, hi_care, hi_value);
+        }
+    }
+
+    // A slice is the cofactor below a path through the upper levels: slice j of
+    // output k at level l holds bits [j * 2^(n-l), (j + 1) * 2^(n-l)) of table k,
+    // its low half is the else cofactor and its high half the then cofactor.
+    // From level L = n - 6 down (the whole table if n < 6) a slice fits in one
+    // word, so a function there is its bit field, kept regular like the edges:
+    // bit 0 clear, complementing the field otherwise.
+    int L = n > 6 ? n - 6 : 0;
+    size_t words = (size_t)nOut << L; // slices at level L
+    auto fieldMask = [](int width) { return width == 64 ? ~0ULL : (1ULL << width) - 1; };
+    auto regular = [&](uint64_t v, int width) { return v & 1 ? ~v & fieldMask(width) : v; };
+    auto sortUnique = [](std::vector<uint64_t>& v) {
+        std::sort(v.begin(), v.end());
+        v.erase(std::unique(v.begin(), v.end()), v.end());
+    };
+
+    // funcs[l]: the distinct regular functions at level l, sorted. Below L
+    // they are the halves of the level above, split with a shift and a mask,
+    // so each level handles its distinct functions rather than every slice.
+    std::vector<std::vector<uint64_t>> funcs(n + 1);
+    funcs[L].reserve(words);
+    for (size_t s = 0; s < words; ++s) {
+        funcs[L].push_back(regular(tables[s >> L].w[s & ((1 << L) - 1)], 1 << (n - L)));
+    }
+    sortUnique(funcs[L]);
+    for (int l = L; l < n; ++l) {
+        int half = 1 << (n - l - 1);
+        for (uint64_t v : funcs[l]) {
+            funcs[l + 1].push_back(regular(v & fieldMask(half), half));
+            funcs[l + 1].push_back(regular(v >> half, half));
+        }
+        sortUnique(funcs[l + 1]);
+    }
+
+    // edges[l][i] is the edge of funcs[l][i]; level n is the terminal.
+    std::vector<std::vector<int>> edges(n + 1);
+    edges[n].assign(1, 0);
+    auto edgeOf = [&](int l, uint64_t v) {
+        int width = 1 << (n - l);
+        int neg = (int)(v & 1);
+        uint64_t key = regular(v, width);
+        size_t i = std::lower_bound(funcs[l].begin(), funcs[l].end(), key) - funcs[l].begin();
+        return edges[l][i] ^ neg;
+    };
+    struct Entry { int e, t, neg, slot; };
+    std::vector<Entry> level_nodes;
+    // Merges the level's pairs by sorting, numbering it like reduceToRobdd,
+    // and stores each pair's edge in out[slot].
+    auto emitLevel = [&](int l, std::vector<int>& out) {
+        std::sort(level_nodes.begin(), level_nodes.end(), [](const Entry& a, const Entry& b) {
+            if (a.e != b.e) return a.e < b.e;
+            return a.t < b.t;
+        });
+        int var_index = var_order[l];
+        for (size_t k = 0; k < level_nodes.size(); ++k) {
+            const Entry& en = level_nodes[k];
+            if (k == 0 || en.e != level_nodes[k - 1].e || en.t != level_nodes[k - 1].t) {
+                nodes.push_back({en.e, en.t, var_index});
+                STATS_INC(stats.nodes_created);
+            }
+            out[en.slot] = (((int)nodes.size() - 1) << 1) | en.neg;
+        }
+    };
+    for (int l = n - 1; l >= L; --l) {
+        int half = 1 << (n - l - 1);
+        edges[l].assign(funcs[l].size(), 0);
+        level_nodes.clear();
+        for (size_t i = 0; i < funcs[l].size(); ++i) {
+            uint64_t v = funcs[l][i];
+            int e = edgeOf(l + 1, v & fieldMask(half)), t = edgeOf(l + 1, v >> half);
+            if (e == t) { edges[l][i] = e; continue; } // equal cofactors: no test
+            level_nodes.push_back({e, t, 0, (int)i});  // bit 0 is clear, so e is regular
+        }
+        emitLevel(l, edges[l]);
+    }
+
+    // Above L a slice spans several words; cur[s] is the edge of slice s at the
+    // level below, so the cofactors of slice s are slices 2s and 2s + 1.
+    std::vector<int> cur(words), next;
+    for (size_t s = 0; s < words; ++s) cur[s] = edgeOf(L, tables[s >> L].w[s & ((1 << L) - 1)]);
+    for (int l = L - 1; l >= 0; --l) {
+        size_t slices = (size_t)nOut << l;
+        next.assign(slices, 0);
+        level_nodes.clear();
+        for (size_t s = 0; s < slices; ++s) {
+            int e = cur[2 * s], t = cur[2 * s + 1];
+            if (e == t) { next[s] = e; continue; } // equal cofactors: no test
+            int neg = e & 1;                       // keep the else edge regular
+            level_nodes.push_back({e ^ neg, t ^ neg, neg, (int)s});
+        }
+        emitLevel(l, next);
+        cur.swap(next);
+    }
+    roots.assign(cur.begin(), cur.begin() + nOut);
+}
+
+bool RobddManager::truthTableFits(int num_inputs, int num_outputs) {
+    return num_inputs <= kMaxTruthTableInputs && ((size_t)num_outputs << num_inputs) <= kMaxTruthTableBits;
+}
+
+bool RobddManager::buildRobddFromTruthTable(const PlaParser& parser) {
+    int n = parser.getNumInputs();
+    if (!truthTableFits(n, parser.getNumOutputs())) {
+        std::cerr << "[Error] The truth-table build supports at most " << kMaxTruthTableInputs << " inputs and "
+                  << kMaxTruthTableBits << " table bits." << std::endl;
+        return false;
+    }
+    resetNodes();
+    var_names = parser.getInputNames();
+    output_names = parser.getOutputNames();
+    roots.clear();
+    resetVarOrder();
+
+    // One word up to 6 inputs, then four times as many per two more inputs.
+    if (n <= 6) buildFromTruthTables<1>(parser);
+    else if (n <= 8) buildFromTruthTables<4>(parser);
+    else if (n <= 10) buildFromTruthTables<16>(parser);
+    else if (n <= 12) buildFromTruthTables<64>(parser);
+    else if (n <= 14) buildFromTruthTables<256>(parser);
+    else buildFromTruthTables<1024>(parser);
+    noteTableBytes();
+
+    // The unique table serves later makeNode calls (updates, sifting, ite).
+    unique_table.reserve(nodes.size());
+    for (size_t id = 2; id < nodes.size(); ++id) {
+        const Node& nd = nodes[id];
+        unique_table.insertNew(nd.var_index, nd.else_id, nd.then_id, (int)id);
+    }
+    return true;
+}
+
+bool RobddManager::buildRobddStreaming(const std::string& filename, PlaParser& parser) {
+    GcHold hold(*this);
+    resetNodes();
+    roots.clear();
+    size_t compact_at = 1 << 16;
+    bool started = false;
+    bool ok = parser.parse(filename, [&](const PlaParser& p, const ProductTerm& term) {
+        if (!started) {
+            // The header is complete once the first term arrives.
+            var_names = p.getInputNames();
+            resetVarOrder();
+            roots.assign(p.getNumOutputs(), 0);
+            started = true;
+        }
+        int c = cubeToBdd(term.cube);
+        for (size_t k = 0; k < roots.size(); ++k) {
+            if (term.inOnSet((int)k)) roots[k] = bddOr(roots[k], c);
+        }
+        if (nodes.size() > compact_at) {
+            noteTableBytes();
+            collectGarbage(); // keeps the cache entries of surviving nodes
+            compact_at = std::max(compact_at, nodes.size() * 2);
+        }
+        return !table_full;
+    });
+    if (!ok || !checkNodeLimit()) return false;
+    var_names = parser.getInputNames();
+    output_names = parser.getOutputNames();
+    if (!started) {
+        resetVarOrder();
+        roots.assign(parser.getNumOutputs(), 0);
+    }
+    noteTableBytes();
+    computed_table.clear();
+    return reduceToRobdd();
+}
+
+// True if the two cubes share an assignment from input v on: no input is '0'
+// in one and '1' in the other.
+static bool cubesIntersect(const char* a, const char* b, int v, int n) {
+    for (; v < n; ++v) {
+        if ((a[v] == '0' && b[v] == '1') || (a[v] == '1' && b[v] == '0')) return false;
+    }
+    return true;
+}
+
+// Appends to out the terms that intersect cube c. by_cube[lo, hi) indexes terms
+// sorted by cube string and sharing their first v literals, so each literal
+// narrows the range with two binary searches: a fixed literal of c keeps the
+// terms with the same literal or '-', and a '-' keeps all three.
+static void findIntersecting(const std::vector<ProductTerm>& terms, const std::vector<int>& by_cube,
+                             size_t lo, size_t hi, int v, int n, const char* c, std::vector<int>& out) {
+    if (hi - lo <= 1 || v == n) {
+        for (size_t i = lo; i < hi; ++i) {
+            if (cubesIntersect(terms[by_cube[i]].cube, c, v, n)) out.push_back(by_cube[i]);
+        }
+        return;
+    }
+    auto first = by_cube.begin();
+    for (char lit : {'-', '0', '1'}) {
+        if (lit != '-' && c[v] != '-' && lit != c[v]) continue;
+        size_t a = std::partition_point(first + lo, first + hi, [&](int t) { return terms[t].cube[v] < lit; }) - first;
+        size_t b = std::partition_point(first + a, first + hi, [&](int t) { return terms[t].cube[v] == lit; }) - first;
+        findIntersecting(terms, by_cube, a, b, v + 1, n, c, out);
+    }
+}
+
+bool RobddManager::updateTerms(const std::vector<ProductTerm>& removed, const std::vector<ProductTerm>& added,
+                               const std::vector<ProductTerm>& current) {
+    int n = (int)var_names.size();
+    // The current terms each removed cube intersects, looked up once for all
+    // outputs through an index of the current terms sorted by cube string.
+    std::vector<std::vector<int>> overlaps(removed.size());
+    if (!removed.empty()) {
+        std::vector<int> by_cube(current.size());
+        for (size_t i = 0; i < by_cube.size(); ++i) by_cube[i] = (int)i;
+        std::sort(by_cube.begin(), by_cube.end(), [&](int a, int b) {
+            return std::char_traits<char>::compare(current[a].cube, current[b].cube, n) < 0;
+        });
+        for (size_t r = 0; r < removed.size(); ++r) {
+            findIntersecting(current, by_cube, 0, by_cube.size(), 0, n, removed[r].cube, overlaps[r]);
+        }
+    }
+    std::vector<size_t> restored(current.size(), 0); // k + 1 once restored into output k
+
+    {
+        GcHold hold(*this);
+        for (size_t k = 0; k < roots.size(); ++k) {
+            // Clear the removed cubes, then restore what other terms still cover there.
+            int mask = 0;
+            for (const ProductTerm& t : removed) {
+                if (t.inOnSet((int)k)) mask = bddOr(mask, cubeToBdd(t.cube));
+            }
+            int f = roots[k];
+            if (mask != 0) {
+                f = bddAnd(f, bddNot(mask));
+                for (size_t r = 0; r < removed.size(); ++r) {
+                    if (!removed[r].inOnSet((int)k)) continue;
+                    for (int i : overlaps[r]) {
+                        if (!current[i].inOnSet((int)k) || restored[i] == k + 1) continue;
+                        restored[i] = k + 1;
+                        f = bddOr(f, cubeToBdd(current[i].cube));
+                    }
+                }
+            }
+            for (const ProductTerm& t : added) {
+                if (t.inOnSet((int)k)) f = bddOr(f, cubeToBdd(t.cube));
+            }
+            roots[k] = f;
+        }
+    }
+    noteTableBytes();
+    if (!checkNodeLimit()) return false;
+    if (gcDue()) collectGarbage();
+    return true;
+}
+
+bool RobddManager::buildRobddParallel(const PlaParser& parser, int threads) {
+    resetNodes();
+    var_names = parser.getInputNames();
+    output_names = parser.getOutputNames();
+    roots.clear();
+    resetVarOrder();
+
+    // The parallel node array has a fixed size; start from a guess and double
+    // until the build fits.
+    size_t capacity = std::max<size_t>(1 << 16, parser.getProductTerms().size() * var_names.size() * 4);
+    for (;;) {
+        ParallelApply pa(var_order, threads);
+        if (pa.build(parser, capacity)) {
+            const auto& pn = pa.getNodes();
+            nodes.reserve(pn.size());
+            for (size_t id = 2; id < pn.size(); ++id) {
+                nodes.push_back({pn[id].else_id, pn[id].then_id, pn[id].var_index});
+            }
+            roots = pa.getRoots();
+            steals = pa.getSteals();
+            STATS_ADD(stats.nodes_created, pn.size() - 2);
+            noteTableBytes(pn.capacity() * sizeof(ParallelApply::Node));
+            break;
+        }
+        if (capacity >= (size_t)1 << 29) {
+            std::cerr << "[Error] Parallel build exceeds " << capacity << " nodes." << std::endl;
+            return false;
+        }
+        capacity *= 2;
+    }
+
+    // Drops intermediate nodes and numbers the result exactly like the sequential build.
+    return reduceToRobdd();
+}
+
+// ---------------- Garbage collection ----------------
+
+RobddManager::Ref::Ref(const Ref& other) : mgr(other.mgr), slot(other.slot) {
+    if (mgr) ++mgr->ref_counts[slot];
+}
+
+RobddManager::Ref& RobddManager::Ref::operator=(const Ref& other) {
+    if (other.mgr) ++other.mgr->ref_counts[other.slot]; // first, in case of self-assignment
+    release();
+    mgr = other.mgr;
+    slot = other.slot;
+    return *this;
+}
+
+int RobddManager::Ref::edge() const {
+    return mgr ? mgr->ref_edges[slot] : 0;
+}
+
+void RobddManager::Ref::release() {
+    if (mgr && --mgr->ref_counts[slot] == 0) {
+        mgr->ref_edges[slot] = 0; // a free slot keeps nothing alive
+        mgr->free_refs.push_back(slot);
+    }
+    mgr = nullptr;
+    slot = -1;
+}
+
+RobddManager::Ref RobddManager::ref(int e) {
+    int slot;
+    if (!free_refs.empty()) {
+        slot = free_refs.back();
+        free_refs.pop_back();
+        ref_edges[slot] = e;
+        ref_counts[slot] = 1;
+    } else {
+        slot = (int)ref_edges.size();
+        ref_edges.push_back(e);
+        ref_counts.push_back(1);
+    }
+    return Ref(this, slot);
+}
+
+void RobddManager::setGcThreshold(size_t min_nodes, double growth) {
+    gc_min_nodes = min_nodes;
+    gc_growth = growth < 1.0 ? 1.0 : growth;
+    gc_next = min_nodes;
+}
+
+size_t RobddManager::collectGarbage() {
+    return collect(nullptr, 0);
+}
+
+size_t RobddManager::collect(int* extra, int n) {
+    size_t N = nodes.size();
+    if (N < 2) return 0;
+
+    // Mark: -2 for reachable nodes; the terminal and the reserved slot stay put.
+    std::vector<int> node_map(N, -1);
+    node_map[0] = 0;
+    node_map[1] = 1;
+    std::vector<int> stack;
+    auto mark = [&](int e) {
+        if (node_map[e >> 1] == -1) { node_map[e >> 1] = -2; stack.push_back(e >> 1); }
+    };
+    for (int r : roots) mark(r);
+    for (int r : ref_edges) mark(r); // freed slots hold FALSE
+    for (int i = 0; i < n; ++i) mark(extra[i]);
+    while (!stack.empty()) {
+        int id = stack.back(); stack.pop_back();
+        mark(nodes[id].else_id);
+        mark(nodes[id].then_id);
+    }
+
+    // Sweep: slide the survivors down in id order, which keeps every child
+    // below its parents, then renumber the children.
+    size_t live = 2;
+    for (size_t id = 2; id < N; ++id) {
+        if (node_map[id] != -2) continue;
+        node_map[id] = (int)live;
+        nodes[live++] = nodes[id];
+    }
+    nodes.resize(live);
+    auto mapEdge = [&](int e) { return (node_map[e >> 1] << 1) | (e & 1); };
+    for (size_t id = 2; id < live; ++id) {
+        nodes[id].else_id = mapEdge(nodes[id].else_id);
+        nodes[id].then_id = mapEdge(nodes[id].then_id);
+    }
+    for (int& r : roots) r = mapEdge(r);
+    for (int& r : ref_edges) r = mapEdge(r);
+    for (int i = 0; i < n; ++i) extra[i] = mapEdge(extra[i]);
+
+    // The unique table holds freed ids; rebuild it over the distinct survivors.
+    unique_table.clear();
+    unique_table.reserve(live);
+    for (size_t id = 2; id < live; ++id) {
+        const Node& nd = nodes[id];
+        unique_table.insertNew(nd.var_index, nd.else_id, nd.then_id, (int)id);
+    }
+    computed_table.remap(node_map);
+
+    if (gc_min_nodes > 0) gc_next = std::max(gc_min_nodes, (size_t)(gc_growth * live));
+    STATS_INC(stats.gc_runs);
+    STATS_ADD(stats.gc_freed, N - live);
+    return N - live;
+}
+
+// ---------------- Variable order ----------------
+
+bool RobddManager::setVarOrder(const std::vector<int>& order) {
+    std::vector<char> seen(order.size(), 0);
+    for (int v : order) {
+        if (v < 0 || v >= (int)order.size() || seen[v]) return false;
+        seen[v] = 1;
+    }
+    initial_order = order;
+    return true;
+}
+
+void RobddManager::resetVarOrder() {
+    int n = (int)var_names.size();
+    var_order.resize(n);
+    var_level.resize(n);
+    bool use_initial = (int)initial_order.size() == n;
+    for (int i = 0; i < n; ++i) var_order[i] = use_initial ? initial_order[i] : i;
+    for (int i = 0; i < n; ++i) var_level[var_order[i]] = i;
+}
+
+// ---------------- Dynamic reordering (Rudell sifting) ----------------
+
+static inline unsigned long long childKey(int else_id, int then_id) {
+    return ((unsigned long long)(unsigned)else_id << 32) | (unsigned)then_id;
+}
+
+// Builds reference counts and per-level unique tables from the nodes reachable
+// from the roots. Unreachable slots go straight to the free list. Sifting
+// reuses those slots for other functions, so the computed cache is dropped.
+void RobddManager::siftInit() {
+    int n = (int)var_names.size();
+    computed_table.clear();
+    level_table.assign(n, std::unordered_map<unsigned long long,int>());
+    ref_count.assign(nodes.size(), 0);
+    free_ids.clear();
+    live_nodes = 0;
+
+    std::vector<char> seen(nodes.size(), 0);
+    std::vector<int> stack;
+    for (int r : roots) {
+        if (!seen[r >> 1]) { seen[r >> 1] = 1; stack.push_back(r >> 1); }
+    }
+    for (int r : ref_edges) {
+        if (!seen[r >> 1]) { seen[r >> 1] = 1; stack.push_back(r >> 1); }
+    }
+    while (!stack.empty()) {
+        int id = stack.back(); stack.pop_back();
+        if (id < 2) continue;
+        const Node& nd = nodes[id];
+        level_table[var_level[nd.var_index]][childKey(nd.else_id, nd.then_id)] = id;
+        ++live_nodes;
+        int kids[2] = {nd.else_id >> 1, nd.then_id >> 1};
+        for (int c : kids) {
+            ++ref_count[c];
+            if (!seen[c]) { seen[c] = 1; stack.push_back(c); }
+        }
+    }
+    for (int r : roots) ++ref_count[r >> 1];
+    for (int r : ref_edges) ++ref_count[r >> 1];
+    for (int id = (int)nodes.size() - 1; id >= 2; --id) {
+        if (!seen[id]) free_ids.push_back(id);
+    }
+}
+
+// Drops the sifting state and compacts the table so ids are topological again.
+void RobddManager::siftDone() {
+    level_table.clear();
+    ref_count.clear();
+    free_ids.clear();
+    live_nodes = 0;
+    noteTableBytes();
+    reduceToRobdd();
+}
+
+int RobddManager::siftMakeNode(int level, int else_id, int then_id) {
+    if (else_id == then_id) {
+        ++ref_count[else_id >> 1];
+        return else_id;
+    }
+    int neg = else_id & 1;
+    else_id ^= neg;
+    then_id ^= neg;
+    unsigned long long key = childKey(else_id, then_id);
+    auto& table = level_table[level];
+    auto it = table.find(key);
+    if (it != table.end()) {
+        ++ref_count[it->second];
+        return (it->second << 1) | neg;
+    }
+
+    int id;
+    if (!free_ids.empty()) {
+        id = free_ids.back(); free_ids.pop_back();
+        nodes[id] = {else_id, then_id, var_order[level]};
+    } else {
+        id = (int)nodes.size();
+        nodes.push_back({else_id, then_id, var_order[level]});
+        ref_count.push_back(0);
+    }
+    STATS_INC(stats.nodes_created);
+    ref_count[id] = 1;
+    ++ref_count[else_id >> 1];
+    ++ref_count[then_id >> 1];
+    table[key] = id;
+    ++live_nodes;
+    return (id << 1) | neg;
+}
+
+void RobddManager::siftDeref(int id) {
+    if (id < 2) return; // terminals are never reclaimed
+    if (--ref_count[id] > 0) return;
+    const Node& nd = nodes[id];
+    level_table[var_level[nd.var_index]].erase(childKey(nd.else_id, nd.then_id));
+    --live_nodes;
+    free_ids.push_back(id);
+    int e = nd.else_id >> 1, t = nd.then_id >> 1;
+    siftDeref(e);
+    siftDeref(t);
+}
+
+// Swaps the variables x (at level) and y (at level+1). Nodes testing x that
+// depend on y are rewritten in place to test y, so their ids and every
+// reference to them stay valid; their new children are x-nodes one level down.
+// The rewritten else edge stays regular because it is built from regular else
+// edges only.
+void RobddManager::swapLevels(int level) {
+    int x = var_order[level], y = var_order[level + 1];
+
+    std::vector<int> xs, ys;
+    xs.reserve(level_table[level].size());
+    ys.reserve(level_table[level + 1].size());
+    for (const auto& kv : level_table[level]) xs.push_back(kv.second);
+    for (const auto& kv : level_table[level + 1]) ys.push_back(kv.second);
+    level_table[level].clear();
+    level_table[level + 1].clear();
+
+    std::swap(var_order[level], var_order[level + 1]);
+    var_level[x] = level + 1;
+    var_level[y] = level;
+
+    // y-nodes keep their variable and simply move up one level.
+    for (int id : ys) level_table[level][childKey(nodes[id].else_id, nodes[id].then_id)] = id;
+
+    // x-nodes that do not depend on y move down unchanged. They must be in the
+    // table before any new x-node is created so duplicates are found.
+    std::vector<int> dependent;
+    for (int id : xs) {
+        const Node& nd = nodes[id];
+        bool d0 = nodes[nd.else_id >> 1].var_index == y;
+        bool d1 = nodes[nd.then_id >> 1].var_index == y;
+        if (d0 || d1) dependent.push_back(id);
+        else level_table[level + 1][childKey(nd.else_id, nd.then_id)] = id;
+    }
+
+    for (int id : dependent) {
+        int f0 = nodes[id].else_id, f1 = nodes[id].then_id;
+        int f00 = f0, f01 = f0, f10 = f1, f11 = f1;
+        if (nodes[f0 >> 1].var_index == y) { f00 = elseOf(f0); f01 = thenOf(f0); }
+        if (nodes[f1 >> 1].var_index == y) { f10 = elseOf(f1); f11 = thenOf(f1); }
+
+        int e = siftMakeNode(level + 1, f00, f10);
+        int t = siftMakeNode(level + 1, f01, f11);
+        nodes[id].var_index = y;
+        nodes[id].else_id = e;
+        nodes[id].then_id = t;
+        level_table[level][childKey(e, t)] = id;
+
+        // The references moved from the old children to the new ones.
+        siftDeref(f0 >> 1);
+        siftDeref(f1 >> 1);
+    }
+}
+
+bool RobddManager::sift(double max_growth, double time_limit_sec) {
+    if (nodes.size() < 2) return false;
+    int n = (int)var_names.size();
+    if (getNodeCount() == 0 || n < 2) return true;
+
+    auto start = std::chrono::steady_clock::now();
+    auto out_of_time = [&]() {
+        std::chrono::duration<double> el = std::chrono::steady_clock::now() - start;
+        return el.count() > time_limit_sec;
+    };
+
+    siftInit();
+
+    // Sift the variables with the largest levels first.
+    std::vector<int> vars(var_order);
+    std::vector<size_t> width(n);
+    for (int v = 0; v < n; ++v) width[v] = level_table[var_level[v]].size();
+    std::stable_sort(vars.begin(), vars.end(), [&](int a, int b) { return width[a] > width[b]; });
+
+    for (int v : vars) {
+        if (out_of_time()) break;
+        int cur = var_level[v];
+        int best_pos = cur;
+        size_t best = live_nodes;
+
+        // Visit the closer end first, then sweep to the other end.
+        bool down_first = cur >= n / 2;
+        for (int pass = 0; pass < 2; ++pass) {
+            bool down = (pass == 0) == down_first;
+            while (down ? cur < n - 1 : cur > 0) {
+                if (down) { swapLevels(cur); ++cur; }
+                else      { swapLevels(cur - 1); --cur; }
+                if (live_nodes < best) { best = live_nodes; best_pos = cur; }
+                if ((double)live_nodes > max_growth * (double)best || out_of_time()) break;
+            }
+        }
+
+        // Settle at the best position seen.
+        while (cur < best_pos) { swapLevels(cur); ++cur; }
+        while (cur > best_pos) { swapLevels(cur - 1); --cur; }
+    }
+
+    siftDone();
+    return true;
+}
+
 // Writes the current BDD to a DOT file for visualization with Graphviz (compat: ROBDD style)
-void RobddManager::writeDot(const std::string& filename) const {
-    writeRobddDot(filename);
+bool RobddManager::writeDot(const std::string& filename) const {
+    return writeRobddDot(filename);
 }
 
 // Helper to compute level (0-based) from full OBDD index i (1..2^n-1)
-static inline int level_from_obdd_index(int i) {
+static inline int level_from_obdd_index(uint64_t i) {
     int lvl = 0;
-    while ((1 << (lvl + 1)) <= i) ++lvl;
+    while (((uint64_t)1 << (lvl + 1)) <= i) ++lvl;
     return lvl;
 }
 
-void RobddManager::writeObddDot(const std::string& filename) const {
-    std::ofstream ofs(filename);
-    if (!ofs.is_open()) {
-        std::cerr << "Cannot write DOT file: " << filename << std::endl; return; }
-    ofs << "digraph OBDD {\n";
+bool RobddManager::writeObddDot(const std::string& filename) const {
+    DotWriter out;
+    if (!out.open(filename)) return false;
+    out.put("digraph OBDD {\n");
 
+    // Heap indices need 2^n; buildObddFromPla only builds trees that obddFits.
     int nVars = (int)var_names.size();
-    int max_internal = (1 << nVars) - 1;
-    int oneId = (1 << nVars);
+    uint64_t max_internal = ((uint64_t)1 << nVars) - 1;
+    uint64_t oneId = (uint64_t)1 << nVars;
+    int nOut = (int)roots.size();
+
+    // With several outputs, tree k uses indices offset by k * 2^n so that all
+    // trees fit in one graph; a single output keeps the plain heap indices.
+    auto offset = [&](int k) { return k * oneId; };
 
     // rank lines
     for (int lvl = 0; lvl < nVars; ++lvl) {
-        int start = 1 << lvl;
-        int end = (1 << (lvl + 1)) - 1;
-        ofs << "{rank=same ";
-        for (int i = start; i <= end; ++i) {
-            ofs << i;
-            if (i < end) ofs << ' ';
-        }
-        ofs << "}\n";
-    }
-
-    // Build mapping: obdd_index -> node id
-    std::vector<int> obddToNode(max_internal + 1, -1); // 0 unused
-    for (const auto& n : nodes) {
-        if (n.var_index >= 0 && n.obdd_index >= 1 && n.obdd_index <= max_internal) {
-            obddToNode[n.obdd_index] = n.id;
+        uint64_t start = (uint64_t)1 << lvl;
+        uint64_t end = ((uint64_t)1 << (lvl + 1)) - 1;
+        out.put("{rank=same ");
+        for (int k = 0; k < nOut; ++k) {
+            for (uint64_t i = start; i <= end; ++i) {
+                out.num(offset(k) + i);
+                if (i < end || k + 1 < nOut) out.put(' ');
+            }
         }
+        out.put("}\n");
     }
 
     // Terminals
-    ofs << "0 [label=\"0\", shape=box];\n";
+    out.put("0 [label=\"0\", shape=box];\n");
 
     // Variable nodes
-    for (int i = 1; i <= max_internal; ++i) {
-        int lvl = level_from_obdd_index(i);
-        ofs << i << " [label=\"" << var_names[lvl] << "\"]\n"; // no semicolon per sample
+    for (int k = 0; k < nOut; ++k) {
+        for (uint64_t i = 1; i <= max_internal; ++i) {
+            int lvl = level_from_obdd_index(i);
+            out.num(offset(k) + i).put(" [label=\"").put(var_names[var_order[lvl]]).put("\"]\n"); // no semicolon per sample
+        }
     }
 
     // Terminal 1
-    ofs << oneId << " [label=\"1\", shape=box];\n";
+    out.num(oneId).put(" [label=\"1\", shape=box];\n");
 
-    // Edges
-    for (int i = 1; i <= max_internal; ++i) {
-        int nodeId = obddToNode[i];
-        if (nodeId < 0) continue; // safety
-        const auto& nd = nodes[nodeId];
-        int e = (nd.else_id == 0) ? 0 : (nd.else_id == 1 ? oneId : nodes[nd.else_id].obdd_index);
-        int t = (nd.then_id == 0) ? 0 : (nd.then_id == 1 ? oneId : nodes[nd.then_id].obdd_index);
-        ofs << i << " -> " << e << " [label=\"0\", style=dotted]\n";
-        ofs << i << " -> " << t << " [label=\"1\", style=solid]\n";
+    // Edges, one level of each tree at a time: the frontier holds the (edge,
+    // heap index) pairs of the level in increasing index order.
+    std::vector<std::pair<int,uint64_t>> level, next;
+    for (int k = 0; k < nOut; ++k) {
+        level.clear();
+        if (roots[k] >= 2) level.push_back({roots[k], 1});
+        while (!level.empty()) {
+            next.clear();
+            for (const auto& cur : level) {
+                uint64_t i = cur.second;
+                int ce = elseOf(cur.first), ct = thenOf(cur.first);
+                uint64_t e = (ce == 0) ? 0 : (ce == 1 ? oneId : offset(k) + i * 2);
+                uint64_t t = (ct == 0) ? 0 : (ct == 1 ? oneId : offset(k) + i * 2 + 1);
+                out.num(offset(k) + i).put(" -> ").num(e).put(" [label=\"0\", style=dotted]\n");
+                out.num(offset(k) + i).put(" -> ").num(t).put(" [label=\"1\", style=solid]\n");
+                if (ce >= 2) next.push_back({ce, i * 2});
+                if (ct >= 2) next.push_back({ct, i * 2 + 1});
+            }
+            level.swap(next);
+        }
     }
 
-    ofs << "}\n";
+    // Output labels pointing at each tree's root
+    if (nOut > 1) {
+        for (int k = 0; k < nOut; ++k) {
+            out.put('o').num(k).put(" [label=\"").put(output_names[k]).put("\", shape=plaintext]\n");
+            uint64_t r = roots[k] < 2 ? (roots[k] == 0 ? 0 : oneId) : offset(k) + 1;
+            out.put('o').num(k).put(" -> ").num(r).put('\n');
+        }
+    }
+
+    out.put("}\n");
+    if (out.close()) return true;
+    std::cerr << "Cannot write DOT file: " << filename << std::endl;
+    return false;
 }
 
-void RobddManager::writeRobddDot(const std::string& filename) const {
-    std::ofstream ofs(filename);
-    if (!ofs.is_open()) {
-        std::cerr << "Cannot write DOT file: " << filename << std::endl; return; }
-    ofs << "digraph ROBDD {\n";
+bool RobddManager::writeRobddDot(const std::string& filename) const {
+    DotWriter out;
+    if (!out.open(filename)) return false;
+    out.put("digraph ROBDD {\n");
 
     int nVars = (int)var_names.size();
-    int oneId = (1 << nVars);
 
-    // Collect surviving nodes per level using their OBDD indices
-    std::map<int, std::vector<int>> level_to_indices; // level -> [obdd_index]
-    for (const auto& n : nodes) {
-        if (n.var_index >= 0 && n.obdd_index > 0) {
-            int lvl = n.var_index; // since var order is fixed a,b,c,...
-            level_to_indices[lvl].push_back(n.obdd_index);
-        }
+    // Every function reachable from the roots (a node seen through a regular or a
+    // complemented edge) is one node of the textbook ROBDD, so the drawing has
+    // only the two terminals and no complement marks.
+    std::vector<char> seen(2 * nodes.size(), 0);
+    std::vector<std::vector<int>> level_edges(nVars); // level -> reachable edges
+    std::vector<int> stack;
+    for (int r : roots) stack.push_back(r);
+    while (!stack.empty()) {
+        int e = stack.back(); stack.pop_back();
+        if (e < 2 || seen[e]) continue;
+        seen[e] = 1;
+        level_edges[topLevel(e)].push_back(e);
+        stack.push_back(elseOf(e));
+        stack.push_back(thenOf(e));
     }
-    for (auto& kv : level_to_indices) {
-        std::sort(kv.second.begin(), kv.second.end());
+
+    // Side table edge -> DOT id, built only for drawing. A single output uses the
+    // smallest full-tree index of any path reaching the function (skipped levels
+    // take the else bit), which is the index the OBDD node it was reduced from
+    // had, so the drawing lines up with the OBDD. A forest numbers the functions
+    // bottom-up from 2 instead, since indices from different roots may coincide;
+    // so does a single output past 62 inputs, where 2^n no longer fits in 64 bits.
+    // The bottom-up order ranks nodes the way reduceToRobdd numbers a fresh
+    // build, by level and then by the ranks of their children, so it does not
+    // depend on the ids that updates or collections left behind.
+    bool forest = roots.size() > 1;
+    bool heap = !forest && nVars <= 62;
+    uint64_t oneId = heap ? (uint64_t)1 << nVars : 1;
+    std::vector<uint64_t> dot_id(2 * nodes.size(), 0); // 0: not assigned yet
+    if (heap) {
+        if (roots[0] >= 2) dot_id[roots[0]] = (uint64_t)1 << topLevel(roots[0]);
+        for (int lvl = 0; lvl < nVars; ++lvl) {
+            for (int e : level_edges[lvl]) {
+                int kids[2] = {elseOf(e), thenOf(e)};
+                for (int b = 0; b < 2; ++b) {
+                    int c = kids[b];
+                    if (c < 2) continue;
+                    uint64_t idx = ((dot_id[e] << 1) | b) << (topLevel(c) - lvl - 1);
+                    if (dot_id[c] == 0 || idx < dot_id[c]) dot_id[c] = idx;
+                }
+            }
+        }
+    } else {
+        std::vector<uint64_t> rank(nodes.size(), 0); // node id -> rank, 0 for the terminal
+        auto rankOf = [&](int e) { return (rank[e >> 1] << 1) | (uint64_t)(e & 1); };
+        std::vector<int> ids;
+        uint64_t next_rank = 2, next = 2;
+        for (int lvl = nVars - 1; lvl >= 0; --lvl) {
+            std::vector<int>& edges = level_edges[lvl];
+            ids.clear();
+            for (int e : edges) ids.push_back(e >> 1);
+            std::sort(ids.begin(), ids.end(), [&](int a, int b) {
+                uint64_t ea = rankOf(nodes[a].else_id), eb = rankOf(nodes[b].else_id);
+                if (ea != eb) return ea < eb;
+                return rankOf(nodes[a].then_id) < rankOf(nodes[b].then_id);
+            });
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end()); // f and !f share a node
+            for (int id : ids) rank[id] = next_rank++;
+            std::sort(edges.begin(), edges.end(), [&](int a, int b) { return rankOf(a) < rankOf(b); });
+            for (int e : edges) dot_id[e] = next++;
+        }
     }
+    auto dotId = [&](int e) { return e < 2 ? (e == 0 ? 0 : oneId) : dot_id[e]; };
+
+    // Terminals
+    out.put("0 [label=\"0\", shape=box];\n");
+    out.num(oneId).put(" [label=\"1\", shape=box];\n");
 
-    // Rank lines (only surviving indices)
+    // One block per level, top-down, in increasing DOT id: the rank line, the
+    // variable nodes and their outgoing edges.
     for (int lvl = 0; lvl < nVars; ++lvl) {
-        auto it = level_to_indices.find(lvl);
-        if (it == level_to_indices.end() || it->second.empty()) continue;
-        ofs << "{rank=same ";
-        for (size_t i = 0; i < it->second.size(); ++i) {
-            ofs << it->second[i];
-            if (i + 1 < it->second.size()) ofs << ' ';
+        std::vector<int>& edges = level_edges[lvl];
+        if (edges.empty()) continue;
+        if (heap) std::sort(edges.begin(), edges.end(), [&](int a, int b) { return dot_id[a] < dot_id[b]; });
+
+        out.put("{rank=same ");
+        for (size_t i = 0; i < edges.size(); ++i) {
+            out.num(dot_id[edges[i]]);
+            if (i + 1 < edges.size()) out.put(' ');
         }
-        ofs << "}\n";
+        out.put("}\n");
+
+        const std::string& label = var_names[var_order[lvl]];
+        for (int e : edges) out.num(dot_id[e]).put(" [label=\"").put(label).put("\"]\n");
+
+        for (int e : edges) {
+            uint64_t idx = dot_id[e];
+            out.num(idx).put(" -> ").num(dotId(elseOf(e))).put(" [label=\"0\", style=dotted]\n");
+            out.num(idx).put(" -> ").num(dotId(thenOf(e))).put(" [label=\"1\", style=solid]\n");
+        }
+        std::vector<int>().swap(edges); // release the level once written
     }
 
-    // Terminals
-    ofs << "0 [label=\"0\", shape=box];\n";
+    // Output labels pointing at the shared roots
+    if (forest) {
+        for (size_t k = 0; k < roots.size(); ++k) {
+            out.put('o').num(k).put(" [label=\"").put(output_names[k]).put("\", shape=plaintext]\n");
+            out.put('o').num(k).put(" -> ").num(dotId(roots[k])).put('\n');
+        }
+    }
+
+    out.put("}\n");
+    if (out.close()) return true;
+    std::cerr << "Cannot write DOT file: " << filename << std::endl;
+    return false;
+}
 
-    // Variable nodes lines (sorted by index)
-    std::vector<std::pair<int,int>> idx_and_level; // (obdd_index, level)
-    for (const auto& kv : level_to_indices) {
-        for (int idx : kv.second) idx_and_level.push_back({idx, kv.first});
+// ---------------- Evaluation ----------------
+
+bool RobddManager::evaluate(const std::vector<char>& values, int k) const {
+    return evaluateEdge(values, roots[k]);
+}
+
+bool RobddManager::evaluateEdge(const std::vector<char>& values, int e) const {
+    while (e >= 2) e = values[nodes[e >> 1].var_index] ? thenOf(e) : elseOf(e);
+    return e == 1;
+}
+
+// Vectors per pass: one 64-bit word, or four with AVX2 (the lane loops below
+// have a constant trip count, so the compiler vectorizes them).
+#ifdef __AVX2__
+static const int kEvalWords = 4;
+#else
+static const int kEvalWords = 1;
+#endif
+
+int RobddManager::getEvalBatchWidth() {
+    return 64 * kEvalWords;
+}
+
+void RobddManager::evaluateBatch(const uint64_t* inputs, size_t words, uint64_t* results) const {
+    const int W = kEvalWords;
+    int nVars = (int)var_names.size();
+    eval_masks.resize(nodes.size() * 2 * W, 0);
+    eval_queued.resize(nodes.size(), 0);
+    std::vector<std::vector<int>> queue(nVars); // per level: nodes reached in this pass
+    uint64_t terminal[2][W];
+
+    // ORs mask m into the vectors reaching edge e and queues its node.
+    auto reach = [&](int e, const uint64_t* m) {
+        uint64_t any = 0;
+        for (int j = 0; j < W; ++j) any |= m[j];
+        if (!any) return;
+        int id = e >> 1;
+        uint64_t* dst = id == 0 ? terminal[e & 1] : &eval_masks[((size_t)id * 2 + (e & 1)) * W];
+        for (int j = 0; j < W; ++j) dst[j] |= m[j];
+        if (id != 0 && !eval_queued[id]) {
+            eval_queued[id] = 1;
+            queue[var_level[nodes[id].var_index]].push_back(id);
+        }
+    };
+
+    for (size_t w0 = 0; w0 < words; w0 += W) {
+        size_t cw = std::min((size_t)W, words - w0);
+        uint64_t all[W];
+        for (int j = 0; j < W; ++j) all[j] = j < (int)cw ? ~0ULL : 0;
+        for (size_t k = 0; k < roots.size(); ++k) {
+            std::fill(&terminal[0][0], &terminal[0][0] + 2 * W, 0);
+            reach(roots[k], all);
+            for (int l = 0; l < nVars; ++l) {
+                for (int id : queue[l]) {
+                    const Node& nd = nodes[id];
+                    const uint64_t* in = inputs + (size_t)nd.var_index * words + w0;
+                    uint64_t x[W], m[2][W], go[W];
+                    for (int j = 0; j < W; ++j) x[j] = j < (int)cw ? in[j] : 0;
+                    uint64_t* src = &eval_masks[(size_t)id * 2 * W];
+                    std::copy(src, src + 2 * W, &m[0][0]);
+                    std::fill(src, src + 2 * W, 0);
+                    eval_queued[id] = 0;
+                    // Polarity p of the incoming edge is pushed down onto both children.
+                    for (int p = 0; p < 2; ++p) {
+                        for (int j = 0; j < W; ++j) go[j] = m[p][j] & ~x[j];
+                        reach(nd.else_id ^ p, go);
+                        for (int j = 0; j < W; ++j) go[j] = m[p][j] & x[j];
+                        reach(nd.then_id ^ p, go);
+                    }
+                }
+                queue[l].clear();
+            }
+            for (size_t j = 0; j < cw; ++j) results[k * words + w0 + j] = terminal[1][j];
+        }
     }
-    std::sort(idx_and_level.begin(), idx_and_level.end());
-    for (auto& p : idx_and_level) {
-        ofs << p.first << " [label=\"" << var_names[p.second] << "\"]\n";
+}
+
+// ---------------- Counting and enumeration ----------------
+
+long double RobddManager::probability(const std::vector<double>& probs, int k) const {
+    // Per node, the probabilities of the regular function being 0 and being 1.
+    // Keeping both avoids computing 1 - p on complemented edges, which would
+    // lose small probabilities to cancellation. Children have smaller ids.
+    std::vector<long double> p0(nodes.size()), p1(nodes.size());
+    p0[0] = 1; // node 0 is FALSE
+    p1[0] = 0;
+    auto prob = [&](int e, bool one) { return ((e & 1) != 0) != one ? p1[e >> 1] : p0[e >> 1]; };
+    for (size_t id = 2; id < nodes.size(); ++id) {
+        const Node& nd = nodes[id];
+        if (nd.var_index < 0) continue;
+        long double q = probs[nd.var_index];
+        p0[id] = (1 - q) * prob(nd.else_id, false) + q * prob(nd.then_id, false);
+        p1[id] = (1 - q) * prob(nd.else_id, true) + q * prob(nd.then_id, true);
     }
+    return prob(roots[k], true);
+}
 
-    // Terminal 1
-    ofs << oneId << " [label=\"1\", shape=box];\n";
+long double RobddManager::satCount(int k) const {
+    std::vector<double> half(var_names.size(), 0.5);
+    return std::ldexp(probability(half, k), (int)var_names.size());
+}
+
+RobddManager::CubeCursor RobddManager::cubes(int k) const {
+    CubeCursor c;
+    c.mgr = this;
+    c.path.assign(var_names.size(), '-');
+    c.stack.push_back({roots[k], 0});
+    return c;
+}
 
-    // Build mapping from obdd_index to current node id index in nodes vector
-    std::unordered_map<int,int> obddToNode;
-    for (const auto& n : nodes) {
-        if (n.var_index >= 0 && n.obdd_index > 0) obddToNode[n.obdd_index] = n.id;
+// Depth-first over the paths from the root, else branch first. A frame is
+// popped once both branches are done, and FALSE branches are never entered.
+bool RobddManager::CubeCursor::next(std::string& cube) {
+    while (!stack.empty()) {
+        Frame& f = stack.back();
+        if (f.edge < 2) {
+            bool sat = f.edge == 1;
+            stack.pop_back();
+            if (sat) {
+                cube = path;
+                return true;
+            }
+            continue;
+        }
+        int v = mgr->nodes[f.edge >> 1].var_index;
+        if (f.branch == 2) {
+            path[v] = '-';
+            stack.pop_back();
+            continue;
+        }
+        int child = f.branch == 0 ? mgr->elseOf(f.edge) : mgr->thenOf(f.edge);
+        path[v] = f.branch == 0 ? '0' : '1';
+        ++f.branch;
+        if (child != 0) stack.push_back({child, 0});
     }
+    return false;
+}
 
-    // Edges using OBDD indices
-    for (auto& p : idx_and_level) {
-        int idx = p.first;
-        int nodeId = obddToNode[idx];
-        const auto& nd = nodes[nodeId];
-        int e = (nd.else_id == 0) ? 0 : (nd.else_id == 1 ? oneId : nodes[nd.else_id].obdd_index);
-        int t = (nd.then_id == 0) ? 0 : (nd.then_id == 1 ? oneId : nodes[nd.then_id].obdd_index);
-        ofs << idx << " -> " << e << " [label=\"0\", style=dotted]\n";
-        ofs << idx << " -> " << t << " [label=\"1\", style=solid]\n";
+size_t RobddManager::getOutputNodeCount(int k) const {
+    if (k < 0 || k >= (int)roots.size()) return 0;
+    std::vector<char> seen(nodes.size(), 0);
+    std::vector<int> stack(1, roots[k] >> 1);
+    size_t count = 0;
+    while (!stack.empty()) {
+        int id = stack.back(); stack.pop_back();
+        if (id < 2 || seen[id]) continue;
+        seen[id] = 1;
+        ++count;
+        stack.push_back(nodes[id].else_id >> 1);
+        stack.push_back(nodes[id].then_id >> 1);
     }
+    return count;
+}
 
-    ofs << "}\n";
+// Formats an edge for the node table: constants as 0/1, otherwise the node id
+// with a leading '~' when the edge is complemented.
+static std::string edgeLabel(int e) {
+    if (e < 2) return e == 0 ? "0" : "1";
+    return (e & 1 ? "~" : "") + std::to_string(e >> 1);
 }
 
 void RobddManager::printTable() const {
     std::cout << "ID\tVar\tElse\tThen" << std::endl;
-    for (const auto& n : nodes) {
+    for (size_t id = 0; id < nodes.size(); ++id) {
+        const Node& n = nodes[id];
         if (n.var_index == -1) {
-            std::cout << n.id << '\t' << (n.id==0?"0":"1") << "\t-\t-" << std::endl;
+            std::cout << id << '\t' << (id==0?"0":"1") << "\t-\t-" << std::endl;
         } else {
-            std::cout << n.id << '\t' << var_names[n.var_index] << '\t' << n.else_id << '\t' << n.then_id << std::endl;
+            std::cout << id << '\t' << var_names[n.var_index] << '\t' << edgeLabel(n.else_id) << '\t' << edgeLabel(n.then_id) << std::endl;
         }
     }
-    std::cout << "Root = " << root_id << std::endl;
+    if (roots.size() == 1) {
+        std::cout << "Root = " << edgeLabel(roots[0]) << std::endl;
+    } else {
+        std::cout << "Roots =";
+        for (size_t k = 0; k < roots.size(); ++k) std::cout << ' ' << output_names[k] << ':' << edgeLabel(roots[k]);
+        std::cout << std::endl;
+    }
+    std::cout << "Order =";
+    for (int v : var_order) std::cout << ' ' << var_names[v];
+    std::cout << std::endl;
 }
@@ -4,64 +4,364 @@
 #include <unordered_map>
 #include <string>
 #include "PlaParser.h"
+#include "UniqueTable.h"
+#include "ComputedCache.h"
+#include "Stats.h"
 
 // Manages the creation and storage of an Ordered Binary Decision Diagram (OBDD)
 // and its reduction to an ROBDD.
+//
+// Functions are referenced by edges: (node id << 1) | complement bit. Node 0 is
+// the single terminal, so edge 0 is FALSE and edge 1 is TRUE, and f and !f share
+// one subgraph. Node id 1 is reserved, so internal node ids start at 2.
 class RobddManager {
 public:
+    // Edges are ints, so node ids stay below 2^30; a build that would exceed
+    // this fails instead of wrapping around.
+    static const size_t kMaxNodes = (size_t)1 << 30;
+
+    // Largest OBDD tree (all outputs together) buildObddFromPla attempts. The
+    // tree has 2^(n+1) nodes per output, so past this the OBDD view is skipped
+    // and callers build the ROBDD directly.
+    static const size_t kMaxObddNodes = (size_t)1 << 24;
+    static bool obddFits(int num_inputs, int num_outputs);
+
     // Builds the OBDD from the boolean function defined in the PLA parser
     // (no on-the-fly reduction; it only returns terminals when the sub-function
-    // becomes a constant). Returns true on success.
+    // becomes a constant). Returns false if the tree exceeds kMaxObddNodes.
     bool buildObddFromPla(const PlaParser& parser);
 
     // Reduces the currently built OBDD to an ROBDD by applying the two
     // reduction rules bottom-up (eliminate redundant tests and merge isomorphic nodes).
+    // Iterative and level-bucketed (Bryant), linear apart from a per-level sort.
+    // On a table that is already reduced it drops unreachable nodes and numbers
+    // the rest as a fresh build would; the computed cache follows the new ids.
     // Returns true on success.
     bool reduceToRobdd();
 
+    // The original recursive, hash-based reducer. Kept as a reference to
+    // cross-check reduceToRobdd (see --verify-reduce). Returns true on success.
+    bool reduceToRobddReference();
+
+    // True if both managers hold the same reduced graph: same order and outputs,
+    // and nodes matched from the roots test the same variables with the same
+    // complement marks. Node ids may differ.
+    bool sameGraph(const RobddManager& other) const;
+
     // Convenience: builds OBDD then reduces to ROBDD.
     bool buildFromPla(const PlaParser& parser);
 
+    // Builds the ROBDD directly without the intermediate OBDD tree: every cube
+    // becomes the AND of its literals and the cubes are ORed together with ite().
+    // Memory stays proportional to the ROBDD instead of 2^n. Returns true on success.
+    bool buildRobddFromPla(const PlaParser& parser);
+
+    // Largest input count, and largest outputs * 2^inputs, that
+    // buildRobddFromTruthTable accepts.
+    static const int kMaxTruthTableInputs = 16;
+    static const size_t kMaxTruthTableBits = (size_t)1 << 22;
+    static bool truthTableFits(int num_inputs, int num_outputs);
+
+    // Same result as buildRobddFromPla for at most kMaxTruthTableInputs inputs:
+    // the cubes are ORed into one packed truth table per output (TruthTable.h,
+    // with the word count fixed at compile time), and the ROBDD is derived
+    // bottom-up, one level at a time. On the six levels inside a word the
+    // cofactors are bit fields, split and compared with shifts and masks, and
+    // only the distinct ones of each level are visited; above that each word is
+    // one edge, and adjacent cofactors are paired and merged by sorting. Equal
+    // cofactors skip the test; there are no ite calls and no hash lookups.
+    // Returns false, with a message, unless truthTableFits.
+    bool buildRobddFromTruthTable(const PlaParser& parser);
+
+    // Same result as buildRobddFromPla, built by `threads` workers with
+    // ParallelApply (work-stealing ite, concurrent unique table and cache).
+    // Returns true on success.
+    bool buildRobddParallel(const PlaParser& parser, int threads);
+
+    // Like buildRobddFromPla, but parses `filename` in streaming mode and ORs each
+    // cube into its outputs as it is read, so the term list is never resident.
+    // Unreachable nodes are compacted away whenever the table doubles.
+    // Returns true on success.
+    bool buildRobddStreaming(const std::string& filename, PlaParser& parser);
+
+    // Updates the reduced ROBDD after the PLA changed by a few terms, without a
+    // rebuild: every output drops the terms in `removed` and gains those in
+    // `added` (same inputs, outputs and names as the build). Output k becomes
+    // (f & !R) | the terms of `current` that intersect R | the added terms,
+    // where R is the OR of its removed cubes and `current` is the full new term
+    // list, so the ite work follows the size of the change. The terms meeting R
+    // are found through an index of `current` sorted by cube string, not by
+    // testing every term against every removed cube. Collects garbage
+    // afterwards if a threshold is set (setGcThreshold). Returns false if the
+    // table ran into kMaxNodes.
+    bool updateTerms(const std::vector<ProductTerm>& removed, const std::vector<ProductTerm>& added,
+                     const std::vector<ProductTerm>& current);
+
+    // Tasks stolen between workers during the last parallel build.
+    size_t getSteals() const { return steals; }
+
+    // Boolean operations on edges of the current ROBDD (0: FALSE, 1: TRUE).
+    // Results are reduced through makeNode and memoized in the computed table.
+    // With a collection threshold set, ite may collect garbage before it starts
+    // (see setGcThreshold); f, g and h are kept, other raw edges are not.
+    int ite(int f, int g, int h);
+    int bddAnd(int f, int g) { return ite(f, g, 0); }
+    int bddOr(int f, int g)  { return ite(f, 1, g); }
+    int bddNot(int f)        { return f ^ 1; } // flips the complement bit
+
+    // Evaluates output k for one assignment (values[v] is input v, 0 or 1) by
+    // walking from the root to the terminal.
+    bool evaluate(const std::vector<char>& values, int k = 0) const;
+
+    // The same walk from any edge, e.g. one returned by ite.
+    bool evaluateEdge(const std::vector<char>& values, int e) const;
+
+    // Evaluates every output for a batch of assignments, bit-parallel. The
+    // batch is transposed: inputs[v * words + w] holds input v for vectors
+    // 64w .. 64w+63, and results[k * words + w] receives output k for them.
+    // Each pass decides getEvalBatchWidth() vectors together by propagating
+    // masks top-down, level by level, through the nodes they reach.
+    // Uses internal scratch space, so it must not run concurrently on one manager.
+    void evaluateBatch(const uint64_t* inputs, size_t words, uint64_t* results) const;
+    static int getEvalBatchWidth();
+
+    // Number of assignments to all inputs for which output k is 1. Computed in
+    // one bottom-up pass over the node table; long double keeps n > 64 in range.
+    long double satCount(int k = 0) const;
+
+    // Probability that output k is 1 when each input v is 1 independently with
+    // probability probs[v]. satCount is this with every probability 0.5, times 2^n.
+    long double probability(const std::vector<double>& probs, int k = 0) const;
+
+    // Streams the satisfying cubes of one output: every path to TRUE is one cube,
+    // the cubes are disjoint, and only the current path is stored. The manager
+    // must not change while a cursor is in use.
+    class CubeCursor {
+    public:
+        // Sets cube to the next satisfying cube, one character per input in .ilb
+        // order ('0', '1', or '-' for a skipped variable). Returns false at the end.
+        bool next(std::string& cube);
+
+    private:
+        friend class RobddManager;
+        struct Frame {
+            int edge;
+            int branch; // next child to visit: 0 else, 1 then, 2 done
+        };
+        const RobddManager* mgr;
+        std::vector<Frame> stack;
+        std::string path;
+    };
+    CubeCursor cubes(int k = 0) const;
+
+    // Dynamic variable reordering by Rudell's sifting on the reduced graph.
+    // Each variable is moved through all levels with in-place adjacent swaps and
+    // left at the position giving the fewest nodes. A direction is abandoned once
+    // the graph grows beyond max_growth times the best size seen for that
+    // variable, and sifting stops after time_limit_sec seconds. Returns true on success.
+    bool sift(double max_growth = 1.2, double time_limit_sec = 10.0);
+
+    // Sets the decision order used by the next build (level -> variable index),
+    // e.g. one computed by VarOrder. Returns false if it is not a permutation.
+    bool setVarOrder(const std::vector<int>& order);
+
+    // Current variable order: level -> variable index into the input names.
+    const std::vector<int>& getVarOrder() const { return var_order; }
+
+    // --- Garbage collection for long-lived managers ---
+    //
+    // The output roots are always kept. Any other function that must survive a
+    // collection is held in a Ref, an external root handle: copies share one
+    // reference count, and the function becomes garbage once the last copy is
+    // gone. Collections compact the table and renumber nodes, so a raw edge is
+    // only valid until the next collection; a Ref follows its function. Refs
+    // also follow reduceToRobdd and sift, are reset to FALSE by the next build,
+    // and must not outlive their manager.
+    class Ref {
+    public:
+        Ref() = default;
+        Ref(const Ref& other);
+        Ref& operator=(const Ref& other);
+        ~Ref() { release(); }
+
+        // Current edge of the function; 0 (FALSE) for an empty Ref.
+        int edge() const;
+        bool empty() const { return mgr == nullptr; }
+
+    private:
+        friend class RobddManager;
+        Ref(RobddManager* m, int s) : mgr(m), slot(s) {}
+        void release();
+        RobddManager* mgr = nullptr;
+        int slot = -1;
+    };
+    Ref ref(int e);
+
+    // Mark-and-sweep: marks every node reachable from the roots and the live
+    // Refs, slides the survivors down in id order (children still precede their
+    // parents), rebuilds the unique table and renumbers the computed cache,
+    // dropping entries that mention a dead node. Returns the nodes reclaimed.
+    size_t collectGarbage();
+
+    // Automatic collection: once the table holds min_nodes nodes, the next
+    // top-level ite collects first, and the next threshold becomes
+    // max(min_nodes, growth * live nodes). min_nodes = 0 (the default) turns
+    // it off. Builds never collect halfway, since they keep partial results in
+    // raw edges.
+    void setGcThreshold(size_t min_nodes, double growth = 2.0);
+
+    // Number of internal (non-terminal) nodes in the node table, shared by all outputs.
+    // With complement edges this is at most the textbook ROBDD size.
+    size_t getNodeCount() const { return nodes.size() < 2 ? 0 : nodes.size() - 2; }
+
+    // Computed-table statistics of the ite engine.
+    size_t getCacheHits() const { return computed_table.hits(); }
+    size_t getCacheMisses() const { return computed_table.misses(); }
+
+    // Build statistics for --stats, accumulated over the manager's lifetime.
+    // Only updated when compiled with ROBDD_STATS (see Stats.h).
+    struct Stats {
+        size_t nodes_created = 0;    // nodes allocated while building and sifting
+        int max_depth = 0;           // deepest OBDD or ite recursion
+        size_t peak_table_bytes = 0; // node vectors plus unique table at their largest
+        size_t gc_runs = 0;          // collectGarbage calls
+        size_t gc_freed = 0;         // nodes reclaimed by them
+    };
+    const Stats& getStats() const { return stats; }
+    const UniqueTable::Counters& getUniqueCounters() const { return unique_table.getCounters(); }
+
+    // Number of internal nodes reachable from output k alone.
+    size_t getOutputNodeCount(int k) const;
+
+    // Root edge of each output, in .ob order.
+    const std::vector<int>& getRoots() const { return roots; }
+    const std::vector<std::string>& getOutputNames() const { return output_names; }
+    const std::vector<std::string>& getInputNames() const { return var_names; }
+
     // Writes the current BDD structure to a file in DOT format for visualization.
-    void writeDot(const std::string& filename) const; // kept for compatibility (ROBDD style)
+    bool writeDot(const std::string& filename) const; // kept for compatibility (ROBDD style)
 
-    // Dedicated writers for OBDD and ROBDD styles
-    void writeObddDot(const std::string& filename) const;
-    void writeRobddDot(const std::string& filename) const;
+    // Dedicated writers for OBDD and ROBDD styles. Output goes through a
+    // DotWriter, so a ".gz" path is written compressed. Return false with a
+    // message if the file cannot be written.
+    bool writeObddDot(const std::string& filename) const;
+    bool writeRobddDot(const std::string& filename) const;
 
     // Prints the internal node table to the console for debugging.
     void printTable() const;
 
 private:
-    // Represents a single node in the BDD.
+    friend class BddImage; // reads and fills the node table directly
+
+    // Represents a single node in the BDD, packed into 12 bytes with both
+    // children next to each other. The id is the position in the table, and
+    // OBDD indices for drawing are derived only by the DOT writers.
     struct Node {
-        int id;          // Unique identifier for this node.
-        int var_index;   // Index of the input variable this node tests. -1 for terminal nodes.
-        int else_id;     // ID of the node to go to if the variable is 0 (else branch).
-        int then_id;     // ID of the node to go to if the variable is 1 (then branch).
-        int obdd_index;  // The index in the full OBDD (1..2^n-1), -1 for terminals or unset.
+        int else_id;     // Edge to follow if the variable is 0; never complemented in a reduced node.
+        int then_id;     // Edge to follow if the variable is 1.
+        int var_index;   // Index of the input variable this node tests. -1 for the terminal.
     };
 
-    std::vector<Node> nodes; // Node table. Node ID is its index. 0: FALSE terminal, 1: TRUE terminal.
-    int root_id = -1;        // The ID of the current root node.
+    std::vector<Node> nodes; // Node table. Node ID is its index. 0: terminal, 1: reserved.
+    std::vector<Node> spare_nodes; // the table before the last reduceToRobdd, reused by the next one
+    std::vector<int> roots;  // Root edge of each output; all outputs share one node table.
     std::vector<std::string> var_names; // Input variable names.
+    std::vector<std::string> output_names; // Output names.
+    std::vector<int> var_order;         // level -> variable index (decision order)
+    std::vector<int> var_level;         // variable index -> level
+    std::vector<int> initial_order;     // order requested through setVarOrder (empty: .ilb order)
 
     // --- Uniqueness table used only in reduction / ROBDD phase ---
-    std::unordered_map<long long, int> unique_table; // (var,e,t) -> node id
+    UniqueTable unique_table; // (var,e,t) with regular e -> node id
+
+    // --- Computed table used by ite() ---
+    ComputedCache computed_table; // normalized (f,g,h) -> result edge
 
-    // Creates a 64-bit key from three integers for the unique_table.
-    long long makeKey(int var_index, int e, int t) const { return ((long long)var_index << 42) ^ ((long long)e << 21) ^ (long long)t; }
+    Stats stats;
+    bool table_full = false; // set once a build hits kMaxNodes
+    int depth = 0; // current ite recursion depth (statistics only)
 
-    // Node creation helpers
+    // External roots of the Ref handles: per slot the edge and the number of
+    // Ref copies holding it; slots whose count dropped to zero are reused.
+    std::vector<int> ref_edges;
+    std::vector<int> ref_counts;
+    std::vector<int> free_refs;
+
+    // Automatic collection state (see setGcThreshold).
+    size_t gc_min_nodes = 0; // 0: off
+    double gc_growth = 2.0;
+    size_t gc_next = 0;      // table size that triggers the next collection
+    int gc_hold = 0;         // > 0 while a build keeps raw edges in locals
+
+    // Suspends automatic collection for its lifetime.
+    struct GcHold {
+        explicit GcHold(RobddManager& m) : mgr(m) { ++mgr.gc_hold; }
+        ~GcHold() { --mgr.gc_hold; }
+        RobddManager& mgr;
+    };
+
+    // Scratch space of evaluateBatch: per node and polarity the vectors reaching
+    // it, all zero between calls, and whether the node is queued.
+    mutable std::vector<uint64_t> eval_masks;
+    mutable std::vector<char> eval_queued;
+
+    // Records the current table footprint plus `extra` bytes held elsewhere.
+    void noteTableBytes(size_t extra = 0) {
+        (void)extra; // unused when STATS_MAX compiles out
+        STATS_MAX(stats.peak_table_bytes, nodes.capacity() * sizeof(Node) + unique_table.bytes() + extra);
+    }
+
+    // Children of an edge, with the edge's complement pushed down.
+    int elseOf(int e) const { return nodes[e >> 1].else_id ^ (e & 1); }
+    int thenOf(int e) const { return nodes[e >> 1].then_id ^ (e & 1); }
+
+    // Empties the table down to the terminal and the reserved slot.
+    void resetNodes();
+
+    // False, with a message, if a build ran into kMaxNodes.
+    bool checkNodeLimit() const;
+
+    // collectGarbage, also keeping (and renumbering) the n edges in extra.
+    size_t collect(int* extra, int n);
+    bool gcDue() const { return gc_min_nodes > 0 && gc_hold == 0 && nodes.size() >= gc_next; }
+
+    // Recursive body of ite; never collects.
+    int iteRec(int f, int g, int h);
+
+    // Node creation helpers; both return edges.
     int makeNode(int var_index, int else_id, int then_id);        // with reduction (ROBDD)
-    int makeNodeNoReduce(int var_index, int else_id, int then_id, int obdd_index); // always creates a new node (OBDD)
+    int makeNodeNoReduce(int var_index, int else_id, int then_id); // always creates a new node (OBDD)
 
     // --- Recursive construction (OBDD only) ---
-    int buildObddRec(int var_index, const std::vector<int>& term_indices, const PlaParser& parser, int cur_obdd_index);  // no reduction, full tree with index
+    // cubes: bitset over the PLA terms (see CubeMatrix) whose non-zero words lie in [lo, hi).
+    int buildObddRec(int level, const uint64_t* cubes, int lo, int hi, const CubeMatrix& m);  // no reduction, full tree
+    std::vector<uint64_t> cube_sets; // per level: else and then cube bitsets while building the OBDD
+
+    // --- Direct ROBDD construction helpers ---
+    int cubeToBdd(const char* cube);  // AND of the cube's literals
+    template <int W> void buildFromTruthTables(const PlaParser& parser); // W words per table
+    int topLevel(int e) const;               // level of an edge's variable, or nVars for terminals
+
+    // Resets the decision order to the requested initial order (or the .ilb order).
+    void resetVarOrder();
+
+    // --- Sifting state; only populated while sift() runs ---
+    std::vector<std::unordered_map<unsigned long long,int>> level_table; // per level: (else,then) -> node id
+    std::vector<int> ref_count;  // parent references (+1 per root) per node id
+    std::vector<int> free_ids;   // dead node slots available for reuse
+    size_t live_nodes = 0;       // internal nodes currently referenced
+
+    size_t steals = 0;           // statistics of the last parallel build
+
+    void siftInit();
+    void siftDone();
+    int siftMakeNode(int level, int else_id, int then_id); // returns an edge holding one new reference
+    void siftDeref(int id);      // drops a reference to a node, reclaiming dead nodes recursively
+    void swapLevels(int level);  // exchanges the variables at level and level+1 in place
 
-    // Reduction of an existing OBDD to ROBDD
-    int reduceRec(int old_id,
+    // Reduction of an existing OBDD to ROBDD (reference reducer)
+    int reduceRec(int old_edge,
                   std::unordered_map<int,int>& map_old_to_new,
-                  std::unordered_map<long long,int>& uniq,
+                  UniqueTable& uniq,
                   std::vector<Node>& new_nodes);
 };
\ No newline at end of file
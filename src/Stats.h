@@ -0,0 +1,19 @@
+#pragma once
+
+// Hot-path counters reported by --stats. The updates are compiled in only when
+// ROBDD_STATS is defined (the Makefile default; build with "make STATS=0" to
+// drop them). Without it every STATS_* macro expands to nothing and the
+// counters stay zero.
+#ifdef ROBDD_STATS
+#define STATS_ENABLED 1
+#define STATS_INC(x) (++(x))
+#define STATS_DEC(x) (--(x))
+#define STATS_ADD(x, n) ((x) += (n))
+#define STATS_MAX(x, v) do { if ((x) < (v)) (x) = (v); } while (0)
+#else
+#define STATS_ENABLED 0
+#define STATS_INC(x) ((void)0)
+#define STATS_DEC(x) ((void)0)
+#define STATS_ADD(x, n) ((void)0)
+#define STATS_MAX(x, v) ((void)0)
+#endif
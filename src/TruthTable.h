@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Packed truth table of a function of up to 6 + log2(W) inputs in W 64-bit
+// words. Bit a holds the value at assignment a, where the input at level l is
+// bit n-1-l of a: the top level selects the upper or lower half, so every
+// cofactor is a contiguous slice, and the bottom six levels live inside a word.
+//
+// A cube is split the same way: its literals on the bottom six levels become
+// one in-word mask, and those on the upper levels select the words it covers
+// (word i is covered if i & hi_care == hi_value). W is a power of two.
+template <int W>
+struct TruthTable {
+    uint64_t w[W];
+
+    void clear() {
+        for (int i = 0; i < W; ++i) w[i] = 0;
+    }
+
+    // Visits only the covered words: hi_value plus every subset of the free
+    // word-index bits, so a cube with k free upper levels costs 2^k words.
+    void orCube(uint64_t in_word, uint64_t hi_care, uint64_t hi_value) {
+        const uint64_t free_bits = (uint64_t)(W - 1) & ~hi_care;
+        uint64_t x = 0;
+        do {
+            w[hi_value | x] |= in_word;
+            x = (x - free_bits) & free_bits;
+        } while (x != 0);
+    }
+
+    bool bit(size_t a) const { return (w[a >> 6] >> (a & 63)) & 1; }
+};
+
+// Up to six inputs: the whole table is one word and a cube is a single mask.
+template <>
+struct TruthTable<1> {
+    uint64_t w[1];
+
+    void clear() { w[0] = 0; }
+    void orCube(uint64_t in_word, uint64_t, uint64_t) { w[0] |= in_word; }
+    bool bit(size_t a) const { return (w[0] >> a) & 1; }
+};
+
+// In-word masks: kTruthPattern[b] has bit a set iff bit b of a is set.
+static const uint64_t kTruthPattern[6] = {
+    0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+    0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL,
+};
@@ -0,0 +1,38 @@
+#include "UniqueTable.h"
+
+static size_t roundUpPow2(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+UniqueTable::UniqueTable(size_t min_capacity) : min_capacity(roundUpPow2(min_capacity < 16 ? 16 : min_capacity)) {
+    clear();
+}
+
+void UniqueTable::clear() {
+    slots.assign(min_capacity, Slot{0, 0, 0, -1});
+    mask = min_capacity - 1;
+    count = 0;
+    grow_at = min_capacity * 7 / 10;
+}
+
+void UniqueTable::reserve(size_t entries) {
+    size_t needed = roundUpPow2(entries + entries / 2 + 1); // stays below 0.7 after rounding
+    if (needed > slots.size()) rehash(needed);
+}
+
+// Moves every entry into a table of new_capacity slots (a power of two).
+void UniqueTable::rehash(size_t new_capacity) {
+    std::vector<Slot> old;
+    old.swap(slots);
+    slots.assign(new_capacity, Slot{0, 0, 0, -1});
+    mask = new_capacity - 1;
+    grow_at = new_capacity * 7 / 10;
+    for (const Slot& s : old) {
+        if (s.id < 0) continue;
+        size_t i = hash(s.var_index, s.else_id, s.then_id) & mask;
+        while (slots[i].id >= 0) i = (i + 1) & mask;
+        slots[i] = s;
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Stats.h"
+
+// Open-addressing hash table mapping a node's (var, else, then) to its id.
+// The full triple is stored in each slot, so keys never collide however many
+// nodes exist, and a lookup is a linear probe over contiguous 16-byte slots.
+// The capacity is a power of two and doubles once the load factor passes 0.7.
+class UniqueTable {
+public:
+    // Lookup statistics (see Stats.h); kept across clear().
+    struct Counters {
+        size_t lookups = 0;   // findOrInsert calls
+        size_t hits = 0;      // calls that found an existing node
+        size_t inserts = 0;   // calls that stored a new node
+        size_t probes = 0;    // slots inspected in total
+        size_t max_probe = 0; // longest probe sequence
+    };
+
+    explicit UniqueTable(size_t min_capacity = 1024);
+
+    // Returns the id stored for (var, e, t), or -1 if there is none.
+    int find(int var_index, int else_id, int then_id) const {
+        size_t i = hash(var_index, else_id, then_id) & mask;
+        while (slots[i].id >= 0) {
+            const Slot& s = slots[i];
+            if (s.else_id == else_id && s.then_id == then_id && s.var_index == var_index) return s.id;
+            i = (i + 1) & mask;
+        }
+        return -1;
+    }
+
+    // Returns the id stored for (var, e, t). If there is none, stores new_id and
+    // returns it, so the caller creates the node only when the result is new_id.
+    int findOrInsert(int var_index, int else_id, int then_id, int new_id) {
+        size_t i = hash(var_index, else_id, then_id) & mask;
+        size_t probe = 1;
+        STATS_INC(counters.lookups);
+        while (slots[i].id >= 0) {
+            const Slot& s = slots[i];
+            if (s.else_id == else_id && s.then_id == then_id && s.var_index == var_index) {
+                STATS_INC(counters.hits);
+                STATS_ADD(counters.probes, probe);
+                STATS_MAX(counters.max_probe, probe);
+                return s.id;
+            }
+            i = (i + 1) & mask;
+            ++probe;
+        }
+        STATS_INC(counters.inserts);
+        STATS_ADD(counters.probes, probe);
+        STATS_MAX(counters.max_probe, probe);
+        slots[i] = {var_index, else_id, then_id, new_id};
+        if (++count > grow_at) grow();
+        return new_id;
+    }
+
+    // Stores a key known to be absent (e.g. when rebuilding over distinct nodes).
+    // Not counted in the statistics.
+    void insertNew(int var_index, int else_id, int then_id, int id) {
+        size_t i = hash(var_index, else_id, then_id) & mask;
+        while (slots[i].id >= 0) i = (i + 1) & mask;
+        slots[i] = {var_index, else_id, then_id, id};
+        if (++count > grow_at) grow();
+    }
+
+    // Removes all entries; the capacity shrinks back to the minimum.
+    void clear();
+
+    // Grows so that the given number of entries fits under the load limit.
+    void reserve(size_t entries);
+
+    size_t size() const { return count; }
+    size_t capacity() const { return slots.size(); }
+    size_t bytes() const { return slots.size() * sizeof(Slot); }
+    const Counters& getCounters() const { return counters; }
+
+private:
+    struct Slot {
+        int var_index;
+        int else_id;
+        int then_id;
+        int id; // -1 marks an empty slot
+    };
+
+    std::vector<Slot> slots; // power-of-two length
+    size_t mask = 0;
+    size_t count = 0;
+    size_t grow_at = 0;      // count above which the table doubles
+    size_t min_capacity;
+    Counters counters;
+
+    static size_t hash(int var_index, int else_id, int then_id) {
+        uint64_t h = (uint64_t)(uint32_t)else_id * 0x9E3779B97F4A7C15ULL;
+        h ^= ((uint64_t)(uint32_t)then_id << 32 | (uint32_t)var_index) * 0xC2B2AE3D27D4EB4FULL;
+        h ^= h >> 29;
+        return (size_t)h;
+    }
+
+    void rehash(size_t new_capacity);
+    void grow() { rehash(slots.size() * 2); }
+};
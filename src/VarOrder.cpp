@@ -0,0 +1,151 @@
+#include "VarOrder.h"
+#include <algorithm>
+#include <cmath>
+
+const std::vector<std::string>& VarOrder::heuristics() {
+    static const std::vector<std::string> names = {"ilb", "freq", "care", "force"};
+    return names;
+}
+
+// Sorts columns by descending score; ties keep the .ilb order.
+std::vector<int> VarOrder::byColumnScore(const std::vector<double>& score) {
+    std::vector<int> order(score.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = (int)i;
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return score[a] > score[b]; });
+    return order;
+}
+
+// FORCE (Aloul, Markov, Sakallah): every cube is a hyperedge over its care
+// columns. Each iteration moves every variable to the mean center of gravity of
+// the cubes it appears in, then re-ranks. Keeps the order with the smallest
+// total span (sum over cubes of last level - first level).
+std::vector<int> VarOrder::force(const PlaParser& parser) {
+    int n = parser.getNumInputs();
+    const auto& terms = parser.getProductTerms();
+
+    // Hyperedges as flat lists of care columns.
+    std::vector<int> edge_start(1, 0);
+    std::vector<int> edge_vars;
+    for (const auto& t : terms) {
+        for (int v = 0; v < n; ++v) {
+            if (t.cube[v] == '0' || t.cube[v] == '1') edge_vars.push_back(v);
+        }
+        edge_start.push_back((int)edge_vars.size());
+    }
+    int m = (int)terms.size();
+
+    std::vector<int> order(n), pos(n);
+    for (int v = 0; v < n; ++v) { order[v] = v; pos[v] = v; }
+
+    auto span = [&]() {
+        double total = 0;
+        for (int e = 0; e < m; ++e) {
+            if (edge_start[e] == edge_start[e + 1]) continue;
+            int lo = n, hi = -1;
+            for (int k = edge_start[e]; k < edge_start[e + 1]; ++k) {
+                lo = std::min(lo, pos[edge_vars[k]]);
+                hi = std::max(hi, pos[edge_vars[k]]);
+            }
+            total += hi - lo;
+        }
+        return total;
+    };
+
+    std::vector<int> best_order = order;
+    double best_span = span();
+    std::vector<double> sum(n), cog(m);
+    std::vector<int> deg(n);
+    int stale = 0;
+    for (int iter = 0; iter < 100 && stale < 2; ++iter) {
+        for (int e = 0; e < m; ++e) {
+            int k0 = edge_start[e], k1 = edge_start[e + 1];
+            double s = 0;
+            for (int k = k0; k < k1; ++k) s += pos[edge_vars[k]];
+            cog[e] = k1 > k0 ? s / (k1 - k0) : 0;
+        }
+        std::fill(sum.begin(), sum.end(), 0.0);
+        std::fill(deg.begin(), deg.end(), 0);
+        for (int e = 0; e < m; ++e) {
+            for (int k = edge_start[e]; k < edge_start[e + 1]; ++k) {
+                sum[edge_vars[k]] += cog[e];
+                ++deg[edge_vars[k]];
+            }
+        }
+        std::vector<double> target(n);
+        for (int v = 0; v < n; ++v) target[v] = deg[v] ? sum[v] / deg[v] : pos[v];
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            if (target[a] != target[b]) return target[a] < target[b];
+            return pos[a] < pos[b];
+        });
+        for (int l = 0; l < n; ++l) pos[order[l]] = l;
+
+        double s = span();
+        if (s < best_span) { best_span = s; best_order = order; stale = 0; }
+        else ++stale;
+    }
+    return best_order;
+}
+
+bool VarOrder::compute(const PlaParser& parser, const std::string& heuristic, std::vector<int>& order) {
+    int n = parser.getNumInputs();
+    const auto& terms = parser.getProductTerms();
+
+    if (heuristic == "ilb") {
+        order.resize(n);
+        for (int v = 0; v < n; ++v) order[v] = v;
+    } else if (heuristic == "freq") {
+        std::vector<double> score(n, 0.0);
+        for (const auto& t : terms) {
+            for (int v = 0; v < n; ++v) {
+                if (t.cube[v] == '0' || t.cube[v] == '1') score[v] += 1.0;
+            }
+        }
+        order = byColumnScore(score);
+    } else if (heuristic == "care") {
+        std::vector<double> score(n, 0.0);
+        for (const auto& t : terms) {
+            int k = 0;
+            for (int v = 0; v < n; ++v) k += (t.cube[v] == '0' || t.cube[v] == '1');
+            if (k == 0) continue;
+            for (int v = 0; v < n; ++v) {
+                if (t.cube[v] == '0' || t.cube[v] == '1') score[v] += 1.0 / k;
+            }
+        }
+        order = byColumnScore(score);
+    } else if (heuristic == "force") {
+        order = force(parser);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+double VarOrder::estimateNodes(const PlaParser& parser, const std::vector<int>& order) {
+    int n = (int)order.size();
+    std::vector<int> level(n);
+    for (int l = 0; l < n; ++l) level[order[l]] = l;
+
+    // A cube with care levels [lo, hi] crosses every cut L with lo < L <= hi.
+    std::vector<int> crossing(n + 1, 0);
+    for (const auto& t : parser.getProductTerms()) {
+        int lo = n, hi = -1;
+        for (int v = 0; v < n; ++v) {
+            if (t.cube[v] == '0' || t.cube[v] == '1') {
+                lo = std::min(lo, level[v]);
+                hi = std::max(hi, level[v]);
+            }
+        }
+        if (hi > lo) { ++crossing[lo + 1]; --crossing[hi + 1]; }
+    }
+
+    double total = 0;
+    int c = 0;
+    for (int l = 0; l < n; ++l) {
+        c += crossing[l];
+        double width = std::min(std::ldexp(1.0, l), std::ldexp(1.0, c) + 1.0);
+        // Below the cut only 2^(2^(n-l)) functions exist at all.
+        if (n - l < 10) width = std::min(width, std::ldexp(1.0, 1 << (n - l)));
+        total += width;
+    }
+    return total;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "PlaParser.h"
+
+// Static variable-ordering heuristics computed from the PLA cubes before the
+// BDD is built. An order lists variable indices from the top level down.
+class VarOrder {
+public:
+    // Names accepted by compute(), in the order they are tried by "all".
+    //   ilb   : the order of the .ilb line (no reordering)
+    //   freq  : most literal occurrences per column first
+    //   care  : columns weighted by how much of the space each cube covers
+    //           (a cube with k literals adds 1/k to each of its care columns)
+    //   force : FORCE hypergraph placement with the cubes as hyperedges
+    static const std::vector<std::string>& heuristics();
+
+    // Computes an order with the named heuristic.
+    // Returns true on success, false for an unknown heuristic name.
+    static bool compute(const PlaParser& parser, const std::string& heuristic, std::vector<int>& order);
+
+    // Cheap upper-bound estimate of the ROBDD size under the given order.
+    // At each level L the number of distinct subfunctions is bounded by 2^L and by
+    // 2^c + 1, where c is the number of cubes with literals on both sides of L.
+    static double estimateNodes(const PlaParser& parser, const std::vector<int>& order);
+
+private:
+    static std::vector<int> byColumnScore(const std::vector<double>& score);
+    static std::vector<int> force(const PlaParser& parser);
+};
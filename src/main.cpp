@@ -1,6 +1,27 @@
 #include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <cerrno>
+#include <cstdio>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "BddImage.h"
+#include "DotWriter.h"
 #include "PlaParser.h"
 #include "RobddManager.h"
+#include "VarOrder.h"
 
 // Helper function to print the parsed results for verification.
 void printParseResult(const PlaParser& parser) {
@@ -11,71 +32,1060 @@ void printParseResult(const PlaParser& parser) {
     std::cout << "Variable names (" << parser.getInputNames().size() << ") : ";
     for (const auto& name : parser.getInputNames()) std::cout << name << ' ';
     std::cout << std::endl;
+    if (parser.getNumOutputs() > 1) {
+        std::cout << "Output names (" << parser.getNumOutputs() << ") : ";
+        for (const auto& name : parser.getOutputNames()) std::cout << name << ' ';
+        std::cout << std::endl;
+    }
     std::cout << "Product terms (" << parser.getProductTerms().size() << ") :" << std::endl;
     int c = 1;
     for (const auto& term : parser.getProductTerms()) {
-        std::cout << "  " << c++ << ". cube=" << term.cube << ", output=" << term.output << std::endl;
+        std::string output = term.output ? std::string(term.output, parser.getNumOutputs()) : "1";
+        std::cout << "  " << c++ << ". cube=" << std::string(term.cube, parser.getNumInputs())
+                  << ", output=" << output << std::endl;
     }
     std::cout << "====================================" << std::endl;
 }
 
+// Picks a static variable order before construction. With "all", every heuristic
+// is tried with a direct build and the one giving the fewest nodes wins.
+// Returns false for an unknown heuristic.
+bool chooseVarOrder(const PlaParser& parser, const std::string& heuristic, std::vector<int>& order, double& estimate) {
+    std::vector<std::string> candidates;
+    if (heuristic == "all") candidates = VarOrder::heuristics();
+    else candidates.push_back(heuristic);
+
+    size_t best_actual = 0;
+    for (const auto& name : candidates) {
+        std::vector<int> cand;
+        if (!VarOrder::compute(parser, name, cand)) {
+            std::cerr << "[Error] Unknown ordering heuristic: " << name << std::endl;
+            return false;
+        }
+        double est = VarOrder::estimateNodes(parser, cand);
+        if (candidates.size() == 1) {
+            order = cand;
+            estimate = est;
+            return true;
+        }
+        RobddManager trial;
+        trial.setVarOrder(cand);
+        trial.buildRobddFromPla(parser);
+        size_t actual = trial.getNodeCount();
+        std::cout << "  " << name << ": estimate=" << est << " actual=" << actual << std::endl;
+        if (order.empty() || actual < best_actual) {
+            order = cand;
+            estimate = est;
+            best_actual = actual;
+        }
+    }
+    return true;
+}
+
+// Times the apply build with 1, 2, 4, ... max_threads workers against the
+// sequential build and checks that every run gives the same graph.
+bool runScaleBench(const PlaParser& parser, const std::vector<int>& order, int max_threads) {
+    typedef std::chrono::steady_clock Clock;
+    RobddManager seq;
+    if (!order.empty()) seq.setVarOrder(order);
+    Clock::time_point start = Clock::now();
+    if (!seq.buildRobddFromPla(parser)) return false;
+    double base = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "[Bench] threads  seconds  speedup  steals  nodes" << std::endl;
+    std::cout << "[Bench] seq      " << base << "  1  0  " << seq.getNodeCount() << std::endl;
+
+    std::vector<int> counts;
+    for (int t = 1; t < max_threads; t *= 2) counts.push_back(t);
+    counts.push_back(max_threads);
+    for (int t : counts) {
+        RobddManager par;
+        if (!order.empty()) par.setVarOrder(order);
+        start = Clock::now();
+        if (!par.buildRobddParallel(parser, t)) return false;
+        double secs = std::chrono::duration<double>(Clock::now() - start).count();
+        std::cout << "[Bench] " << t << "        " << secs << "  " << (secs > 0 ? base / secs : 0) << "  "
+                  << par.getSteals() << "  " << par.getNodeCount() << std::endl;
+        if (!par.sameGraph(seq)) {
+            std::cerr << "[Error] Parallel build with " << t << " threads differs from the sequential build." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+typedef std::chrono::steady_clock Clock;
+
+// Wall time of each pipeline phase in milliseconds, in execution order.
+struct PhaseTimer {
+    std::vector<std::pair<std::string, double>> phases;
+    Clock::time_point start = Clock::now();
+
+    void end(const std::string& name) {
+        Clock::time_point now = Clock::now();
+        phases.push_back({name, std::chrono::duration<double, std::milli>(now - start).count()});
+        start = now;
+    }
+};
+
+static std::string jsonString(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+// Writes the --stats report as JSON to path ("-" for standard output).
+// Returns false if the file cannot be written.
+bool writeStatsJson(const std::string& path, const std::string& input, const PlaParser& parser,
+                    const RobddManager& mgr, const PhaseTimer& timer, const std::string& cache) {
+    std::ofstream file;
+    if (path != "-") {
+        file.open(path);
+        if (!file) {
+            std::cerr << "[Error] Cannot write stats to " << path << std::endl;
+            return false;
+        }
+    }
+    std::ostream& out = path == "-" ? std::cout : file;
+
+    double total = 0;
+    for (const auto& p : timer.phases) total += p.second;
+    const RobddManager::Stats& st = mgr.getStats();
+    const UniqueTable::Counters& ut = mgr.getUniqueCounters();
+    out << "{\n";
+    out << "  \"input\": " << jsonString(input) << ",\n";
+    out << "  \"inputs\": " << mgr.getInputNames().size() << ",\n";
+    out << "  \"outputs\": " << mgr.getRoots().size() << ",\n";
+    out << "  \"terms\": " << parser.getNumTerms() << ",\n";
+    out << "  \"cache\": " << jsonString(cache) << ",\n";
+    out << "  \"counters_enabled\": " << (STATS_ENABLED ? "true" : "false") << ",\n";
+    out << "  \"phases_ms\": {";
+    for (const auto& p : timer.phases) out << jsonString(p.first) << ": " << p.second << ", ";
+    out << "\"total\": " << total << "},\n";
+    out << "  \"parser\": {\"bytes\": " << parser.getBytesParsed() << ", \"lines\": " << parser.getLinesParsed() << "},\n";
+    out << "  \"nodes\": {\"created\": " << st.nodes_created << ", \"final\": " << mgr.getNodeCount()
+        << ", \"peak_table_bytes\": " << st.peak_table_bytes << "},\n";
+    out << "  \"unique_table\": {\"lookups\": " << ut.lookups << ", \"hits\": " << ut.hits
+        << ", \"inserts\": " << ut.inserts << ", \"probes\": " << ut.probes
+        << ", \"mean_probe\": " << (ut.lookups ? (double)ut.probes / ut.lookups : 0.0)
+        << ", \"max_probe\": " << ut.max_probe << "},\n";
+    out << "  \"computed_cache\": {\"hits\": " << mgr.getCacheHits() << ", \"misses\": " << mgr.getCacheMisses() << "},\n";
+    out << "  \"recursion\": {\"max_depth\": " << st.max_depth << "}\n";
+    out << "}" << std::endl;
+    return true;
+}
+
+// Evaluates the first count vectors of a transposed block, laid out as for
+// RobddManager::evaluateBatch. Returns false if the graph cannot be walked.
+typedef std::function<bool(const uint64_t* inputs, size_t words, size_t count, uint64_t* results)> BlockEval;
+
+// Simulation mode: reads one input vector per line ('0'/'1' per input in .ilb
+// order; blank and '#' lines are skipped) and writes one line of output bits per
+// vector. Vectors are evaluated in transposed blocks through eval, so the file
+// is streamed. "-" means stdin / stdout. how describes eval for the summary
+// line. Returns false on bad input.
+bool runEval(const BlockEval& eval, int num_inputs, size_t num_outputs, const std::string& how,
+             const std::string& in_path, const std::string& out_path) {
+    std::ifstream in_file;
+    std::ofstream out_file;
+    if (in_path != "-") {
+        in_file.open(in_path);
+        if (!in_file) {
+            std::cerr << "[Error] Cannot open " << in_path << std::endl;
+            return false;
+        }
+    }
+    if (out_path != "-") {
+        out_file.open(out_path);
+        if (!out_file) {
+            std::cerr << "[Error] Cannot write " << out_path << std::endl;
+            return false;
+        }
+    }
+    std::istream& in = in_path == "-" ? std::cin : in_file;
+    std::ostream& out = out_path == "-" ? std::cout : out_file;
+
+    const size_t block = 4096; // vectors per eval call
+    const size_t words = block / 64;
+    std::vector<uint64_t> inputs(num_inputs * words), results(num_outputs * words);
+    std::string line, row(num_outputs, '0');
+    size_t count = 0, line_no = 0, total = 0;
+    auto flush = [&]() {
+        if (!eval(inputs.data(), words, count, results.data())) return false;
+        for (size_t i = 0; i < count; ++i) {
+            for (size_t k = 0; k < num_outputs; ++k) {
+                row[k] = (results[k * words + i / 64] >> (i % 64)) & 1 ? '1' : '0';
+            }
+            out << row << '\n';
+        }
+        std::fill(inputs.begin(), inputs.end(), 0);
+        total += count;
+        count = 0;
+        return true;
+    };
+    while (std::getline(in, line)) {
+        ++line_no;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+        int v = 0;
+        for (size_t i = first; i < line.size() && line[i] != '#'; ++i) {
+            char c = line[i];
+            if (c == ' ' || c == '\t' || c == '\r') continue;
+            if ((c != '0' && c != '1') || v >= num_inputs) { v = -1; break; }
+            if (c == '1') inputs[(size_t)v * words + count / 64] |= 1ULL << (count % 64);
+            ++v;
+        }
+        if (v != num_inputs) {
+            std::cerr << "[Error] " << in_path << ":" << line_no << ": expected " << num_inputs << " input bits" << std::endl;
+            return false;
+        }
+        if (++count == block && !flush()) break;
+    }
+    bool ok = count == 0 || flush();
+    out.flush();
+    if (!ok) {
+        std::cerr << "[Error] Corrupt graph while evaluating vector " << total + 1 << std::endl;
+        return false;
+    }
+    std::ostream& log = out_path == "-" ? std::cerr : std::cout; // keep stdout results clean
+    log << "[OK] Evaluated " << total << " vectors (" << how << ")." << std::endl;
+    return true;
+}
+
+// The two evaluators of runEval: the manager's bit-parallel batch, and a walk
+// of the mapped image per vector.
+BlockEval managerEval(const RobddManager& mgr) {
+    return [&mgr](const uint64_t* inputs, size_t words, size_t, uint64_t* results) {
+        mgr.evaluateBatch(inputs, words, results);
+        return true;
+    };
+}
+
+BlockEval imageEval(const BddImage& image) {
+    std::vector<char> values(image.getNumInputs());
+    return [&image, values](const uint64_t* inputs, size_t words, size_t count, uint64_t* results) mutable {
+        int num_outputs = image.getNumOutputs();
+        std::fill(results, results + (size_t)num_outputs * words, 0);
+        for (size_t i = 0; i < count; ++i) {
+            for (size_t v = 0; v < values.size(); ++v) values[v] = (inputs[v * words + i / 64] >> (i % 64)) & 1;
+            for (int k = 0; k < num_outputs; ++k) {
+                bool value;
+                if (!image.evaluate(values, k, value)) return false;
+                if (value) results[k * words + i / 64] |= 1ULL << (i % 64);
+            }
+        }
+        return true;
+    };
+}
+
+// Parses the --prob list: one probability in [0, 1] per input, comma-separated.
+bool parseProbs(const std::string& list, int num_inputs, std::vector<double>& probs) {
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t comma = list.find(',', pos);
+        if (comma == std::string::npos) comma = list.size();
+        char* end = nullptr;
+        std::string item = list.substr(pos, comma - pos);
+        double p = std::strtod(item.c_str(), &end);
+        if (item.empty() || *end != '\0' || p < 0 || p > 1) {
+            std::cerr << "[Error] Bad probability in --prob: " << item << std::endl;
+            return false;
+        }
+        probs.push_back(p);
+        pos = comma + 1;
+    }
+    if ((int)probs.size() != num_inputs) {
+        std::cerr << "[Error] --prob needs " << num_inputs << " probabilities, got " << probs.size() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// One "[OK] Output" line of --count: the satisfying-vector count and density.
+void printCount(const std::string& name, long double count, int num_inputs) {
+    std::cout << "[OK] Output " << name << ": " << std::setprecision(20) << count
+              << " of 2^" << num_inputs << " vectors (density " << std::setprecision(6)
+              << std::ldexp(count, -num_inputs) << ")" << std::endl;
+}
+
+// Prints the number of satisfying input vectors and the on-set density of each
+// output, its signal probability if probs is given (P(input = 1) in .ilb order),
+// then, if max_cubes >= 0, up to max_cubes disjoint satisfying cubes (0 = all).
+void printCounts(const RobddManager& mgr, int num_inputs, const std::vector<double>& probs, long max_cubes) {
+    for (size_t k = 0; k < mgr.getRoots().size(); ++k) {
+        printCount(mgr.getOutputNames()[k], mgr.satCount((int)k), num_inputs);
+        if (!probs.empty()) {
+            std::cout << "[OK] Output " << mgr.getOutputNames()[k] << ": P(1) = "
+                      << (double)mgr.probability(probs, (int)k) << std::endl;
+        }
+        if (max_cubes < 0) continue;
+        RobddManager::CubeCursor cursor = mgr.cubes((int)k);
+        std::string cube;
+        long printed = 0;
+        while ((max_cubes == 0 || printed < max_cubes) && cursor.next(cube)) {
+            std::cout << "  " << cube << std::endl;
+            ++printed;
+        }
+        if (cursor.next(cube)) std::cout << "  ... (more cubes not shown)" << std::endl;
+    }
+}
+
+// Cache entry for a PLA: <dir>/<key>.robdd, where the key hashes the file
+// contents and the options that change the result (the ordering ones; every
+// build mode gives the same reduced graph). Creates dir if needed.
+bool cacheImagePath(const std::string& dir, const std::string& pla, const std::string& order_heuristic,
+                    bool sift, double sift_growth, double sift_time, std::string& path, uint64_t& key) {
+    uint64_t contents;
+    if (!BddImage::hashFile(pla, contents)) return false;
+    std::ostringstream options;
+    options << "image=" << BddImage::kVersion << " order=" << order_heuristic << " sift=" << sift;
+    if (sift) options << " growth=" << sift_growth << " time=" << sift_time;
+    std::string opt = options.str();
+    key = BddImage::hashBytes(opt.data(), opt.size(), contents);
+
+    if (mkdir(dir.c_str(), 0777) != 0 && errno != EEXIST) {
+        std::cerr << "[Error] Cannot create cache directory " << dir << std::endl;
+        return false;
+    }
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.robdd", (unsigned long long)key);
+    path = dir + "/" + name;
+    return true;
+}
+
+// Per-run settings of --batch, shared read-only by the workers.
+struct BatchOptions {
+    std::string out_dir;
+    std::string build_mode; // "obdd", "apply", "table" or "auto"
+    bool write_obdd = false;
+    std::string order_heuristic;
+    bool sift = false;
+    double sift_growth = 1.2;
+    double sift_time = 10.0;
+};
+
+// Outcome of one --batch file, one row of the summary report.
+struct BatchResult {
+    std::string input;
+    bool ok = false;
+    std::string error;
+    int inputs = 0;
+    int outputs = 0;
+    size_t terms = 0;
+    size_t nodes = 0;
+    double ms = 0;
+};
+
+// File name without directory and extension.
+static std::string fileStem(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    return dot == std::string::npos || dot == 0 ? name : name.substr(0, dot);
+}
+
+// Inputs of a --batch run: the *.pla files of a directory, or the paths listed
+// in a manifest (one per line, blank and '#' lines skipped), sorted either way.
+static bool listBatchInputs(const std::string& source, std::vector<std::string>& inputs) {
+    struct stat st;
+    if (stat(source.c_str(), &st) != 0) {
+        std::cerr << "[Error] Cannot open " << source << std::endl;
+        return false;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        DIR* dir = opendir(source.c_str());
+        if (!dir) {
+            std::cerr << "[Error] Cannot read directory " << source << std::endl;
+            return false;
+        }
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".pla") == 0) inputs.push_back(source + "/" + name);
+        }
+        closedir(dir);
+    } else {
+        std::ifstream manifest(source);
+        std::string line;
+        while (std::getline(manifest, line)) {
+            size_t first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos || line[first] == '#') continue;
+            size_t last = line.find_last_not_of(" \t\r");
+            inputs.push_back(line.substr(first, last - first + 1));
+        }
+    }
+    std::sort(inputs.begin(), inputs.end());
+    return true;
+}
+
+// Builds one PLA of a batch and writes <out_dir>/<stem>_robdd.dot (and
+// _obdd.dot), the names the Makefile's per-file rule uses. The parser and
+// manager belong to the calling worker and keep their storage between files.
+static void processBatchFile(const BatchOptions& opt, PlaParser& parser, RobddManager& mgr, BatchResult& r) {
+    Clock::time_point start = Clock::now();
+    if (!parser.parse(r.input)) {
+        r.error = "parse failed";
+        return;
+    }
+    r.inputs = parser.getNumInputs();
+    r.outputs = parser.getNumOutputs();
+    r.terms = parser.getNumTerms();
+
+    std::vector<int> order;
+    if (!opt.order_heuristic.empty() && !VarOrder::compute(parser, opt.order_heuristic, order)) {
+        r.error = "unknown ordering heuristic";
+        return;
+    }
+    mgr.setVarOrder(order); // empty: the .ilb order
+
+    std::string base = opt.out_dir + "/" + fileStem(r.input);
+    if (opt.build_mode == "obdd" && RobddManager::obddFits(r.inputs, r.outputs)) {
+        if (!mgr.buildObddFromPla(parser)) {
+            r.error = "OBDD build failed";
+            return;
+        }
+        if (opt.write_obdd && !mgr.writeObddDot(base + "_obdd.dot")) {
+            r.error = "cannot write OBDD DOT";
+            return;
+        }
+        if (!mgr.reduceToRobdd()) {
+            r.error = "reduction failed";
+            return;
+        }
+    } else if (opt.build_mode == "table" ||
+               (opt.build_mode == "auto" && RobddManager::truthTableFits(r.inputs, r.outputs))) {
+        if (!mgr.buildRobddFromTruthTable(parser)) {
+            r.error = "truth-table build failed";
+            return;
+        }
+    } else if (!mgr.buildRobddFromPla(parser)) {
+        r.error = "ROBDD build failed";
+        return;
+    }
+    if (opt.sift && !mgr.sift(opt.sift_growth, opt.sift_time)) {
+        r.error = "sifting failed";
+        return;
+    }
+    if (!mgr.writeRobddDot(base + "_robdd.dot")) {
+        r.error = "cannot write ROBDD DOT";
+        return;
+    }
+    r.nodes = mgr.getNodeCount();
+    r.ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    r.ok = true;
+}
+
+// Batch mode: builds every input of source on a pool of `threads` workers,
+// each with its own parser and manager, then writes the CSV report. Failures
+// are recorded per file and do not stop the run. Returns false if any failed.
+bool runBatch(const std::string& source, const BatchOptions& opt, int threads, const std::string& report_path) {
+    std::vector<std::string> inputs;
+    if (!listBatchInputs(source, inputs)) return false;
+    if (mkdir(opt.out_dir.c_str(), 0777) != 0 && errno != EEXIST) {
+        std::cerr << "[Error] Cannot create output directory " << opt.out_dir << std::endl;
+        return false;
+    }
+    std::vector<BatchResult> results(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i) results[i].input = inputs[i];
+    // Files with the same stem would overwrite each other's DOT files.
+    std::vector<std::pair<std::string, size_t>> stems;
+    for (size_t i = 0; i < inputs.size(); ++i) stems.push_back({fileStem(inputs[i]), i});
+    std::sort(stems.begin(), stems.end());
+    for (size_t i = 1; i < stems.size(); ++i) {
+        if (stems[i].first == stems[i - 1].first) results[stems[i].second].error = "duplicate output name";
+    }
+
+    threads = std::max(1, std::min(threads, (int)inputs.size()));
+    std::cout << "[Info] Batch: " << inputs.size() << " files on " << threads
+              << (threads == 1 ? " thread" : " threads") << " ..." << std::endl;
+    Clock::time_point start = Clock::now();
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        PlaParser parser;
+        RobddManager mgr;
+        for (size_t i; (i = next.fetch_add(1)) < results.size();) {
+            if (results[i].error.empty()) processBatchFile(opt, parser, mgr, results[i]);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+    double secs = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::ofstream report(report_path);
+    if (!report) {
+        std::cerr << "[Error] Cannot write " << report_path << std::endl;
+        return false;
+    }
+    report << "input,status,inputs,outputs,terms,robdd_nodes,ms,error\n";
+    size_t failed = 0;
+    for (const auto& r : results) {
+        report << r.input << ',' << (r.ok ? "ok" : "failed") << ',' << r.inputs << ',' << r.outputs << ','
+               << r.terms << ',' << r.nodes << ',' << r.ms << ',' << r.error << '\n';
+        if (!r.ok) {
+            ++failed;
+            std::cerr << "[Error] " << r.input << ": " << r.error << std::endl;
+        }
+    }
+    std::cout << "[OK] Batch: " << results.size() - failed << " of " << results.size() << " files built in "
+              << secs << " s, report written to " << report_path << std::endl;
+    return failed == 0;
+}
+
+// Modification stamp of a file for --watch: size and mtime, with nanoseconds
+// where the platform reports them. Returns false if the file cannot be read.
+static bool fileStamp(const std::string& path, std::pair<long long, long long>& stamp) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return false;
+#ifdef __APPLE__
+    long long ns = (long long)st.st_mtimespec.tv_sec * 1000000000LL + st.st_mtimespec.tv_nsec;
+#else
+    long long ns = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+#endif
+    stamp = {(long long)st.st_size, ns};
+    return true;
+}
+
+// Splits the terms of two parses of one PLA into those only in `before`
+// (removed) and those only in `after` (added). A term is its cube plus its
+// output plane, so a changed plane counts as one removal and one addition;
+// duplicates are matched one to one.
+static void diffTerms(const PlaParser& before, const PlaParser& after, std::vector<ProductTerm>& removed,
+                      std::vector<ProductTerm>& added) {
+    int n_in = after.getNumInputs(), n_out = after.getNumOutputs();
+    auto key = [&](const ProductTerm& t) {
+        std::string k(t.cube, n_in);
+        if (t.output) k.append(t.output, n_out);
+        return k;
+    };
+    std::unordered_map<std::string, std::vector<size_t>> unmatched; // key -> indices into before
+    const std::vector<ProductTerm>& old_terms = before.getProductTerms();
+    for (size_t i = 0; i < old_terms.size(); ++i) unmatched[key(old_terms[i])].push_back(i);
+    for (const ProductTerm& t : after.getProductTerms()) {
+        auto it = unmatched.find(key(t));
+        if (it != unmatched.end() && !it->second.empty()) it->second.pop_back();
+        else added.push_back(t);
+    }
+    for (const auto& p : unmatched) {
+        for (size_t i : p.second) removed.push_back(old_terms[i]);
+    }
+}
+
+// Watch mode: polls the PLA every interval_ms and, when it changed, re-parses
+// it, diffs the terms against the previous parse and applies only the delta
+// with RobddManager::updateTerms, then rewrites the DOT (if any). A change of
+// inputs or outputs falls back to a full build. Stops after max_updates
+// updates (-1: never). Returns false if an update fails.
+bool runWatch(const std::string& pla_path, const std::string& dot_path, PlaParser& parser, RobddManager& mgr,
+              int interval_ms, long max_updates) {
+    PlaParser other;
+    PlaParser* prev = &parser;
+    PlaParser* cur = &other;
+    std::pair<long long, long long> stamp, now;
+    if (!fileStamp(pla_path, stamp)) {
+        std::cerr << "[Error] Cannot stat " << pla_path << std::endl;
+        return false;
+    }
+    // Updates leave replaced functions behind; collect once the table doubles.
+    mgr.setGcThreshold(std::max<size_t>(1 << 16, 2 * mgr.getNodeCount()));
+    std::cout << "[Info] Watching " << pla_path << " for changes (Ctrl-C to stop) ..." << std::endl;
+    for (long updates = 0; max_updates < 0 || updates < max_updates;) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+        if (!fileStamp(pla_path, now) || now == stamp) continue;
+        stamp = now;
+        Clock::time_point start = Clock::now();
+        if (!cur->parse(pla_path)) {
+            std::cerr << "[Error] Parse failed; keeping the previous function." << std::endl;
+            continue;
+        }
+        if (cur->getInputNames() != prev->getInputNames() || cur->getOutputNames() != prev->getOutputNames()) {
+            std::cout << "[Info] Inputs or outputs changed; rebuilding ..." << std::endl;
+            if (!mgr.buildRobddFromPla(*cur)) {
+                std::cerr << "[Error] ROBDD build failed." << std::endl;
+                return false;
+            }
+            std::cout << "[OK] Rebuilt: ";
+        } else {
+            std::vector<ProductTerm> removed, added;
+            diffTerms(*prev, *cur, removed, added);
+            if (removed.empty() && added.empty()) {
+                std::swap(prev, cur);
+                continue;
+            }
+            if (!mgr.updateTerms(removed, added, cur->getProductTerms())) {
+                std::cerr << "[Error] Incremental update failed." << std::endl;
+                return false;
+            }
+            std::cout << "[OK] Update: -" << removed.size() << " +" << added.size() << " terms, ";
+        }
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        std::cout << mgr.getNodeCount() << " nodes in table, " << ms << " ms" << std::endl;
+        if (!dot_path.empty() && !mgr.writeRobddDot(dot_path)) return false;
+        std::swap(prev, cur);
+        ++updates;
+    }
+    return true;
+}
+
+// Prints command-line usage.
+void printUsage(const char* prog) {
+    std::cout << "Usage: " << prog << " [options] <input.pla|input.robdd> <output.dot>" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --no-obdd          Do not write the OBDD DOT (implies --build apply)" << std::endl;
+    std::cout << "  --build MODE       Construction mode: obdd (full OBDD then reduce), apply (direct ROBDD via ite)," << std::endl;
+    std::cout << "                     table (truth table, up to 16 inputs) or auto (table if it fits, else apply)" << std::endl;
+    std::cout << "  --verify-reduce    Cross-check the reducer against the recursive reference reducer" << std::endl;
+    std::cout << "  --order H          Static variable order before building: ilb, freq, care, force, or all" << std::endl;
+    std::cout << "  --sift             Reorder variables by sifting after the ROBDD is built" << std::endl;
+    std::cout << "  --sift-growth X    Abort a sifting direction beyond X times the best size (default 1.2)" << std::endl;
+    std::cout << "  --sift-time S      Stop sifting after S seconds (default 10)" << std::endl;
+    std::cout << "  --eval IN OUT      Evaluate the vectors in IN (one per line) into OUT (- for stdin/stdout); DOT path optional" << std::endl;
+    std::cout << "  --count            Print the satisfying-vector count and density of each output; DOT path optional" << std::endl;
+    std::cout << "  --prob P0,P1,...   With --count, also print each output's probability given P(input = 1) per input" << std::endl;
+    std::cout << "  --cubes N          With --count, also list up to N disjoint satisfying cubes per output (0 = all)" << std::endl;
+    std::cout << "  --save FILE        Write the reduced ROBDD as a binary image (.robdd), readable as an input" << std::endl;
+    std::cout << "  --cache DIR        Reuse images in DIR keyed by the PLA contents and ordering options (implies --no-obdd)" << std::endl;
+    std::cout << "  --print-table      Print the internal node table" << std::endl;
+    std::cout << "  --verbose          Print the parsed PLA (inputs, outputs and every product term)" << std::endl;
+    std::cout << "  --stats FILE       Write phase timings and build counters as JSON (- for stdout)" << std::endl;
+    std::cout << "  --stream           Build while parsing without keeping the term list (implies --build apply)" << std::endl;
+    std::cout << "  --threads N        Build the ROBDD with N worker threads (apply build)" << std::endl;
+    std::cout << "  --batch            Arguments are <dir|manifest> <out_dir>: build every PLA on a thread pool (--threads, default: all cores)" << std::endl;
+    std::cout << "  --batch-report F   CSV summary of a --batch run (default: <out_dir>/summary.csv)" << std::endl;
+    std::cout << "  --scale-bench      Time the apply build from 1 to N threads (--threads, default: all cores) and exit" << std::endl;
+    std::cout << "  --watch            After the build, poll the PLA and apply each edit incrementally, rewriting the DOT" << std::endl;
+    std::cout << "  --watch-interval MS  Polling period of --watch (default 500)" << std::endl;
+    std::cout << "  --watch-count N    Stop --watch after N updates (default: run until interrupted)" << std::endl;
+    std::cout << "Example: ./robdd pla_files/input.pla output.dot" << std::endl;
+}
+
 // This is the main entry point of the program.
 int main(int argc, char* argv[]) {
-    // Check for correct command-line arguments.
-    if (argc != 3) {
-        std::cout << "Usage: " << argv[0] << " <input.pla> <output.dot>" << std::endl;
-        std::cout << "Example: ./robdd pla_files/input.pla output.dot" << std::endl;
+    // Parse options; the two remaining arguments are the input and output paths.
+    bool write_obdd = true;
+    std::string build_mode;
+    std::string order_heuristic;
+    bool verify_reduce = false;
+    bool do_sift = false;
+    double sift_growth = 1.2;
+    double sift_time = 10.0;
+    int threads = 0; // 0: not given
+    bool scale_bench = false;
+    bool batch = false;
+    std::string batch_report;
+    bool stream = false;
+    bool print_table = false;
+    bool verbose = false;
+    std::string stats_path;
+    std::string eval_in, eval_out;
+    bool count = false;
+    long max_cubes = -1;
+    std::string prob_list;
+    std::string save_path;
+    std::string cache_dir;
+    bool watch = false;
+    int watch_interval = 500;
+    long watch_count = -1;
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--no-obdd") {
+            write_obdd = false;
+        } else if (arg == "--build" && i + 1 < argc) {
+            build_mode = argv[++i];
+        } else if (arg == "--verify-reduce") {
+            verify_reduce = true;
+        } else if (arg == "--order" && i + 1 < argc) {
+            order_heuristic = argv[++i];
+        } else if (arg == "--sift") {
+            do_sift = true;
+        } else if (arg == "--sift-growth" && i + 1 < argc) {
+            sift_growth = std::atof(argv[++i]);
+        } else if (arg == "--sift-time" && i + 1 < argc) {
+            sift_time = std::atof(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+            if (threads < 1) {
+                std::cerr << "[Error] --threads needs a positive count." << std::endl;
+                return 1;
+            }
+        } else if (arg == "--eval" && i + 2 < argc) {
+            eval_in = argv[++i];
+            eval_out = argv[++i];
+        } else if (arg == "--count") {
+            count = true;
+        } else if (arg == "--cubes" && i + 1 < argc) {
+            max_cubes = std::atol(argv[++i]);
+            if (max_cubes < 0) {
+                std::cerr << "[Error] --cubes needs a non-negative count." << std::endl;
+                return 1;
+            }
+            count = true;
+        } else if (arg == "--prob" && i + 1 < argc) {
+            prob_list = argv[++i];
+            count = true;
+        } else if (arg == "--save" && i + 1 < argc) {
+            save_path = argv[++i];
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if (arg == "--print-table") {
+            print_table = true;
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else if (arg == "--stats" && i + 1 < argc) {
+            stats_path = argv[++i];
+        } else if (arg == "--stream") {
+            stream = true;
+        } else if (arg == "--batch") {
+            batch = true;
+        } else if (arg == "--batch-report" && i + 1 < argc) {
+            batch_report = argv[++i];
+        } else if (arg == "--scale-bench") {
+            scale_bench = true;
+        } else if (arg == "--watch") {
+            watch = true;
+        } else if (arg == "--watch-interval" && i + 1 < argc) {
+            watch_interval = std::atoi(argv[++i]);
+            if (watch_interval < 1) {
+                std::cerr << "[Error] --watch-interval needs a positive number of milliseconds." << std::endl;
+                return 1;
+            }
+            watch = true;
+        } else if (arg == "--watch-count" && i + 1 < argc) {
+            watch_count = std::atol(argv[++i]);
+            if (watch_count < 1) {
+                std::cerr << "[Error] --watch-count needs a positive count." << std::endl;
+                return 1;
+            }
+            watch = true;
+        } else if (arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+            std::cerr << "[Error] Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    // Check for correct command-line arguments; the benchmark, --eval, --count and --watch need no DOT.
+    bool dot_optional = scale_bench || !eval_in.empty() || count || watch;
+    if (positional.size() != 2 && !(dot_optional && positional.size() == 1)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (positional.size() == 1) write_obdd = false;
+    // An image is already reduced; it only supports the steps after the build.
+    bool from_image = BddImage::isImage(positional[0]);
+    if (from_image) {
+        if (build_mode == "obdd" || !order_heuristic.empty() || stream || scale_bench) {
+            std::cerr << "[Error] --build obdd, --order, --stream and --scale-bench need a PLA input, not an image." << std::endl;
+            return 1;
+        }
+        write_obdd = false;
+    }
+    // Watching diffs the term lists of successive parses, so it needs a parsed PLA.
+    if (watch && (from_image || stream || batch || scale_bench || !cache_dir.empty())) {
+        std::cerr << "[Error] --watch needs a PLA input and does not combine with --stream, --cache, --batch or --scale-bench." << std::endl;
+        return 1;
+    }
+    // Streaming feeds the apply build directly; everything else needs the term list.
+    if (stream) {
+        if (build_mode == "obdd" || build_mode == "table" || !order_heuristic.empty() || threads > 1 || scale_bench) {
+            std::cerr << "[Error] --stream only supports the single-threaded apply build without --order." << std::endl;
+            return 1;
+        }
+        build_mode = "apply";
+        write_obdd = false;
+    }
+    // The cache holds reduced graphs, so unless --build obdd asks for the tree it drops the OBDD DOT.
+    if (!cache_dir.empty() && build_mode != "obdd") write_obdd = false;
+    // The OBDD tree is exponential in .i, so only build it when its DOT is wanted;
+    // otherwise "auto" takes the truth-table build when it fits, else apply.
+    if (build_mode.empty()) build_mode = write_obdd ? "obdd" : "auto";
+    if (build_mode != "obdd" && build_mode != "apply" && build_mode != "table" && build_mode != "auto") {
+        std::cerr << "[Error] Unknown build mode: " << build_mode << std::endl;
         return 1;
     }
+    if (build_mode != "obdd") write_obdd = false;
 
-    std::string pla_filepath = argv[1];
-    std::string dot_filepath = argv[2];
+    if (batch) {
+        if (positional.size() != 2 || stream || scale_bench || count || !eval_in.empty() || !save_path.empty() ||
+            !cache_dir.empty() || !stats_path.empty() || print_table || order_heuristic == "all") {
+            std::cerr << "[Error] --batch takes <dir|manifest> <out_dir> and supports --no-obdd, --build, "
+                         "--order (not all), --sift options and --threads." << std::endl;
+            return 1;
+        }
+        BatchOptions opt;
+        opt.out_dir = positional[1];
+        opt.build_mode = build_mode;
+        opt.write_obdd = write_obdd;
+        opt.order_heuristic = order_heuristic;
+        opt.sift = do_sift;
+        opt.sift_growth = sift_growth;
+        opt.sift_time = sift_time;
+        int workers = threads > 0 ? threads : (int)std::thread::hardware_concurrency();
+        if (batch_report.empty()) batch_report = opt.out_dir + "/summary.csv";
+        return runBatch(positional[0], opt, workers < 1 ? 1 : workers, batch_report) ? 0 : 1;
+    }
+
+    std::string pla_filepath = positional[0];
+    std::string dot_filepath = positional.size() > 1 ? positional[1] : "";
     std::cout << "Input PLA file : " << pla_filepath << '\n';
-    std::cout << "Output DOT file: " << dot_filepath << '\n';
+    if (!dot_filepath.empty()) std::cout << "Output DOT file: " << dot_filepath << '\n';
 
-    // 1. Parse the PLA file.
+    // A .robdd image as input, or a --cache hit, replaces parsing and construction.
+    PhaseTimer timer;
     PlaParser parser;
-    if (!parser.parse(pla_filepath)) {
-        std::cerr << "[Error] Parse failed." << std::endl;
-        return 1;
+    RobddManager mgr;
+    bool loaded = false;
+    std::string cache_state = "off";
+    std::string cache_path;
+    uint64_t cache_key = 0;
+    if (from_image) {
+        BddImage image;
+        if (!image.open(pla_filepath)) return 1;
+        // --eval and plain --count read the mapped graph; the other steps need a manager.
+        if (dot_filepath.empty() && save_path.empty() && stats_path.empty() && !print_table &&
+            prob_list.empty() && max_cubes < 0) {
+            std::cout << "[OK] Mapped ROBDD image: " << image.getNodeCount() << " nodes." << std::endl;
+            if (count) {
+                for (int k = 0; k < image.getNumOutputs(); ++k)
+                    printCount(image.getOutputNames()[k], image.satCount(k), image.getNumInputs());
+            }
+            if (!eval_in.empty()) {
+                std::cout << "[Info] Evaluating vectors from " << eval_in << " ..." << std::endl;
+                std::cout.flush();
+                if (!runEval(imageEval(image), image.getNumInputs(), image.getNumOutputs(), "mapped image",
+                             eval_in, eval_out)) return 1;
+            }
+            return 0;
+        }
+        if (!image.toManager(mgr)) return 1;
+        std::cout << "[OK] Loaded ROBDD image: " << mgr.getNodeCount() << " nodes." << std::endl;
+        loaded = true;
+        timer.end("load_image");
+    } else if (!cache_dir.empty()) {
+        if (write_obdd || scale_bench) {
+            std::cout << "[Info] --cache skipped: the OBDD DOT and --scale-bench need a full build." << std::endl;
+        } else {
+            if (!cacheImagePath(cache_dir, pla_filepath, order_heuristic, do_sift, sift_growth, sift_time,
+                                cache_path, cache_key)) return 1;
+            BddImage image;
+            if (BddImage::isImage(cache_path) && image.open(cache_path) && image.getKey() == cache_key &&
+                image.toManager(mgr)) {
+                std::cout << "[OK] Cache hit: " << cache_path << std::endl;
+                cache_state = "hit";
+                loaded = true;
+            } else {
+                std::cout << "[Info] Cache miss: " << cache_path << std::endl;
+                cache_state = "miss";
+            }
+            timer.end("cache_lookup");
+        }
     }
-    std::cout << "[OK] Parsing successful." << std::endl;
-    printParseResult(parser); // (Optional) Print parsed results for verification.
 
-    // 2. Build OBDD first
-    RobddManager mgr;
-    std::cout << "[Info] Building OBDD ..." << std::endl;
-    if (!mgr.buildObddFromPla(parser)) {
-        std::cerr << "[Error] OBDD build failed." << std::endl;
-        return 1;
+    // 1. Parse the PLA file (in streaming mode, while building below).
+    if (!stream && !loaded) {
+        if (!parser.parse(pla_filepath)) {
+            std::cerr << "[Error] Parse failed." << std::endl;
+            return 1;
+        }
+        std::cout << "[OK] Parsing successful." << std::endl;
+        if (verbose) printParseResult(parser); // (Optional) Print parsed results for verification.
+        timer.end("parse");
     }
 
-    // Derive OBDD dot path: append _obdd before .dot if present.
-    std::string obdd_dot_path = dot_filepath;
-    if (obdd_dot_path.size() >= 4 && obdd_dot_path.substr(obdd_dot_path.size()-4) == ".dot") {
-        obdd_dot_path = obdd_dot_path.substr(0, obdd_dot_path.size()-4) + "_obdd.dot";
-    } else {
-        obdd_dot_path += "_obdd.dot";
+    bool report_order = false;
+    double order_estimate = 0;
+    std::vector<int> order;
+    if (!order_heuristic.empty() && !loaded) {
+        std::cout << "[Info] Computing static variable order (" << order_heuristic << ") ..." << std::endl;
+        if (!chooseVarOrder(parser, order_heuristic, order, order_estimate)) return 1;
+        mgr.setVarOrder(order);
+        std::cout << "[OK] Variable order:";
+        for (int v : order) std::cout << ' ' << parser.getInputNames()[v];
+        std::cout << std::endl;
+        report_order = true;
+        timer.end("order");
     }
 
-    std::cout << "[Info] Writing OBDD DOT ..." << std::endl;
-    mgr.writeObddDot(obdd_dot_path);
-    std::cout << "[OK] OBDD DOT written to: " << obdd_dot_path << std::endl;
+    // The OBDD tree doubles with every input; when it cannot fit, build directly.
+    if (build_mode == "obdd" && !RobddManager::obddFits(parser.getNumInputs(), parser.getNumOutputs())) {
+        std::cout << "[Info] The OBDD tree for " << parser.getNumInputs() << " inputs exceeds "
+                  << RobddManager::kMaxObddNodes << " nodes; skipping the OBDD view"
+                  << (verify_reduce ? " and --verify-reduce" : "") << " and building the ROBDD directly." << std::endl;
+        build_mode = "apply";
+        write_obdd = false;
+    }
 
-    // 3. Reduce to ROBDD and write final DOT to the specified path.
-    std::cout << "[Info] Reducing to ROBDD ..." << std::endl;
-    if (!mgr.reduceToRobdd()) {
-        std::cerr << "[Error] ROBDD reduction failed." << std::endl;
-        return 1;
+    if (scale_bench) {
+        int max_threads = threads > 1 ? threads : (int)std::thread::hardware_concurrency();
+        if (max_threads < 1) max_threads = 1;
+        std::cout << "[Info] Scaling benchmark up to " << max_threads << " threads ..." << std::endl;
+        return runScaleBench(parser, order, max_threads) ? 0 : 1;
     }
-    std::cout << "[OK] ROBDD built. Printing node table:" << std::endl;
-    mgr.printTable(); // (Optional) Print the final node table for debugging.
 
-    std::cout << "[Info] Writing ROBDD DOT ..." << std::endl;
-    mgr.writeRobddDot(dot_filepath);
-    std::cout << "[OK] ROBDD DOT written to: " << dot_filepath << std::endl;
-    std::cout << "You can run: dot -Tpng " << obdd_dot_path << " -o obdd_graph.png" << std::endl;
-    std::cout << "You can run: dot -Tpng " << dot_filepath << " -o graph.png" << std::endl;
+    std::string obdd_dot_path;
+    if (loaded) {
+        // Already reduced (and sifted, if the cached build was).
+    } else if (build_mode == "obdd") {
+        if (threads > 1) std::cout << "[Info] --threads only applies to the apply build; building on one thread." << std::endl;
+        // 2. Build OBDD first
+        std::cout << "[Info] Building OBDD ..." << std::endl;
+        if (!mgr.buildObddFromPla(parser)) {
+            std::cerr << "[Error] OBDD build failed." << std::endl;
+            return 1;
+        }
+        timer.end("build_obdd");
+
+        if (write_obdd) {
+            // Derive OBDD dot path: append _obdd before .dot if present.
+            // A ".gz" suffix is kept, so foo.dot.gz gives foo_obdd.dot.gz.
+            obdd_dot_path = dot_filepath;
+            std::string gz;
+            if (DotWriter::isGzipPath(obdd_dot_path)) {
+                obdd_dot_path.resize(obdd_dot_path.size() - 3);
+                gz = ".gz";
+            }
+            if (obdd_dot_path.size() >= 4 && obdd_dot_path.substr(obdd_dot_path.size()-4) == ".dot") {
+                obdd_dot_path = obdd_dot_path.substr(0, obdd_dot_path.size()-4) + "_obdd.dot" + gz;
+            } else {
+                obdd_dot_path += "_obdd.dot" + gz;
+            }
+
+            std::cout << "[Info] Writing OBDD DOT ..." << std::endl;
+            if (!mgr.writeObddDot(obdd_dot_path)) return 1;
+            std::cout << "[OK] OBDD DOT written to: " << obdd_dot_path << std::endl;
+            timer.end("obdd_dot");
+        }
 
+        // 3. Reduce to ROBDD and write final DOT to the specified path.
+        RobddManager reference;
+        if (verify_reduce) reference = mgr;
+        std::cout << "[Info] Reducing to ROBDD ..." << std::endl;
+        if (!mgr.reduceToRobdd()) {
+            std::cerr << "[Error] ROBDD reduction failed." << std::endl;
+            return 1;
+        }
+        timer.end("reduce");
+        if (verify_reduce) {
+            if (!reference.reduceToRobddReference() || !mgr.sameGraph(reference)) {
+                std::cerr << "[Error] Reducer differs from the reference reducer." << std::endl;
+                return 1;
+            }
+            std::cout << "[OK] Reducer matches the reference reducer." << std::endl;
+            timer.end("verify_reduce");
+        }
+    } else if (build_mode == "table" ||
+               (build_mode == "auto" && threads <= 1 &&
+                RobddManager::truthTableFits(parser.getNumInputs(), parser.getNumOutputs()))) {
+        // 2. Small function: derive the ROBDD from packed truth tables.
+        if (threads > 1) std::cout << "[Info] --threads only applies to the apply build; building on one thread." << std::endl;
+        std::cout << "[Info] Building ROBDD (truth table) ..." << std::endl;
+        if (!mgr.buildRobddFromTruthTable(parser)) {
+            std::cerr << "[Error] ROBDD build failed." << std::endl;
+            return 1;
+        }
+        timer.end("build_table");
+    } else {
+        // 2. Build the ROBDD directly with the ite engine.
+        if (stream) {
+            std::cout << "[Info] Building ROBDD (apply, streaming) ..." << std::endl;
+            if (!mgr.buildRobddStreaming(pla_filepath, parser)) {
+                std::cerr << "[Error] ROBDD build failed." << std::endl;
+                return 1;
+            }
+            std::cout << "[OK] Streamed " << parser.getNumTerms() << " product terms." << std::endl;
+        } else if (threads > 1) {
+            std::cout << "[Info] Building ROBDD (apply, " << threads << " threads) ..." << std::endl;
+            if (!mgr.buildRobddParallel(parser, threads)) {
+                std::cerr << "[Error] ROBDD build failed." << std::endl;
+                return 1;
+            }
+            std::cout << "[Info] Work stealing: " << mgr.getSteals() << " tasks stolen" << std::endl;
+        } else {
+            std::cout << "[Info] Building ROBDD (apply) ..." << std::endl;
+            if (!mgr.buildRobddFromPla(parser)) {
+                std::cerr << "[Error] ROBDD build failed." << std::endl;
+                return 1;
+            }
+            if (STATS_ENABLED) {
+                std::cout << "[Info] Computed cache: " << mgr.getCacheHits() << " hits, "
+                          << mgr.getCacheMisses() << " misses" << std::endl;
+            }
+        }
+        timer.end(stream ? "parse_and_build" : "build_apply");
+    }
+    if (mgr.getRoots().size() > 1) {
+        // Shared count vs. what separate per-output BDDs would need.
+        size_t separate = 0;
+        for (size_t k = 0; k < mgr.getRoots().size(); ++k) {
+            size_t cnt = mgr.getOutputNodeCount((int)k);
+            separate += cnt;
+            std::cout << "[Info] Output " << mgr.getOutputNames()[k] << ": " << cnt << " nodes" << std::endl;
+        }
+        std::cout << "[OK] Shared forest: " << mgr.getNodeCount() << " nodes (" << separate
+                  << " if built separately)" << std::endl;
+    }
+    if (report_order) {
+        std::cout << "[OK] Static order: estimated " << order_estimate << " nodes, actual "
+                  << mgr.getNodeCount() << " nodes" << std::endl;
+    }
+    if (do_sift && cache_state != "hit") {
+        size_t before = mgr.getNodeCount();
+        std::cout << "[Info] Sifting variable order ..." << std::endl;
+        if (!mgr.sift(sift_growth, sift_time)) {
+            std::cerr << "[Error] Sifting failed." << std::endl;
+            return 1;
+        }
+        std::cout << "[OK] Sifting: " << before << " -> " << mgr.getNodeCount() << " nodes" << std::endl;
+        std::cout << "[OK] Order after sifting:";
+        for (int v : mgr.getVarOrder()) std::cout << ' ' << mgr.getInputNames()[v];
+        std::cout << std::endl;
+        timer.end("sift");
+    }
+    if (cache_state == "miss") {
+        // A failed store only costs the next run a rebuild.
+        if (BddImage::write(mgr, cache_path, cache_key)) std::cout << "[OK] Cached ROBDD image: " << cache_path << std::endl;
+        timer.end("cache_store");
+    }
+    if (!save_path.empty()) {
+        if (!BddImage::write(mgr, save_path)) return 1;
+        std::cout << "[OK] ROBDD image written to: " << save_path << std::endl;
+        timer.end("save");
+    }
+    std::cout << "[OK] ROBDD built: " << mgr.getNodeCount() << " nodes." << std::endl;
+    if (print_table) mgr.printTable(); // (Optional) Print the final node table for debugging.
+
+    if (!dot_filepath.empty()) {
+        std::cout << "[Info] Writing ROBDD DOT ..." << std::endl;
+        if (!mgr.writeRobddDot(dot_filepath)) return 1;
+        std::cout << "[OK] ROBDD DOT written to: " << dot_filepath << std::endl;
+        timer.end("robdd_dot");
+        if (!obdd_dot_path.empty())
+            std::cout << "You can run: dot -Tpng " << obdd_dot_path << " -o obdd_graph.png" << std::endl;
+        std::cout << "You can run: dot -Tpng " << dot_filepath << " -o graph.png" << std::endl;
+    }
+    if (count) {
+        std::vector<double> probs;
+        if (!prob_list.empty() && !parseProbs(prob_list, (int)mgr.getInputNames().size(), probs)) return 1;
+        printCounts(mgr, (int)mgr.getInputNames().size(), probs, max_cubes);
+        timer.end("count");
+    }
+    if (!eval_in.empty()) {
+        std::cout << "[Info] Evaluating vectors from " << eval_in << " ..." << std::endl;
+        std::cout.flush();
+        std::string how = std::to_string(RobddManager::getEvalBatchWidth()) + " per pass";
+        if (!runEval(managerEval(mgr), (int)mgr.getInputNames().size(), mgr.getRoots().size(), how,
+                     eval_in, eval_out)) return 1;
+        timer.end("eval");
+    }
+
+    // Last, so that "--stats -" leaves the JSON at the end of the output.
+    if (!stats_path.empty() && !writeStatsJson(stats_path, pla_filepath, parser, mgr, timer, cache_state)) return 1;
+
+    if (watch) return runWatch(pla_filepath, dot_filepath, parser, mgr, watch_interval, watch_count) ? 0 : 1;
     return 0;
-}
\ No newline at end of file
+}